@@ -0,0 +1,101 @@
+// agenda.c
+// agenda de desbloqueios por tempo
+// simulador de computador
+// so25b
+
+#include "agenda.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define TAM_INICIAL 8
+
+typedef struct {
+  int data;
+  int pid;
+} evento_t;
+
+struct agenda_t {
+  // número de eventos no heap
+  int n_eventos;
+  // capacidade do vetor de eventos
+  int capacidade;
+  // heap mínimo pela data: o filho de i está em 2i+1 e 2i+2
+  evento_t *eventos;
+};
+
+agenda_t *agenda_cria(void)
+{
+  agenda_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->n_eventos = 0;
+  self->capacidade = TAM_INICIAL;
+  self->eventos = malloc(self->capacidade * sizeof(evento_t));
+  assert(self->eventos != NULL);
+  return self;
+}
+
+void agenda_destroi(agenda_t *self)
+{
+  free(self->eventos);
+  free(self);
+}
+
+static void agenda__troca(agenda_t *self, int i, int j)
+{
+  evento_t aux = self->eventos[i];
+  self->eventos[i] = self->eventos[j];
+  self->eventos[j] = aux;
+}
+
+void agenda_insere(agenda_t *self, int data, int pid)
+{
+  if (self->n_eventos >= self->capacidade) {
+    self->capacidade *= 2;
+    self->eventos = realloc(self->eventos, self->capacidade * sizeof(evento_t));
+    assert(self->eventos != NULL);
+  }
+  // coloca no final e sobe até achar um pai com data menor
+  int i = self->n_eventos++;
+  self->eventos[i].data = data;
+  self->eventos[i].pid = pid;
+  while (i > 0) {
+    int pai = (i - 1) / 2;
+    if (self->eventos[pai].data <= self->eventos[i].data) break;
+    agenda__troca(self, i, pai);
+    i = pai;
+  }
+}
+
+bool agenda_vazia(agenda_t *self)
+{
+  return self->n_eventos == 0;
+}
+
+int agenda_proxima_data(agenda_t *self)
+{
+  assert(self->n_eventos > 0);
+  return self->eventos[0].data;
+}
+
+int agenda_remove(agenda_t *self, int *pdata)
+{
+  assert(self->n_eventos > 0);
+  evento_t primeiro = self->eventos[0];
+  // coloca o último no topo e desce até que os filhos tenham data maior
+  self->n_eventos--;
+  self->eventos[0] = self->eventos[self->n_eventos];
+  int i = 0;
+  for (;;) {
+    int menor = i;
+    int esq = 2 * i + 1;
+    int dir = 2 * i + 2;
+    if (esq < self->n_eventos && self->eventos[esq].data < self->eventos[menor].data) menor = esq;
+    if (dir < self->n_eventos && self->eventos[dir].data < self->eventos[menor].data) menor = dir;
+    if (menor == i) break;
+    agenda__troca(self, i, menor);
+    i = menor;
+  }
+  if (pdata != NULL) *pdata = primeiro.data;
+  return primeiro.pid;
+}
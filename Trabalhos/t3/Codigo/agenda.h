@@ -0,0 +1,44 @@
+// agenda.h
+// agenda de desbloqueios por tempo
+// simulador de computador
+// so25b
+
+#ifndef AGENDA_H
+#define AGENDA_H
+
+// mantém os processos que estão bloqueados até uma determinada data (medida
+//   em instruções executadas, como em relogio_agora), ordenados pela data
+// é implementada como um heap mínimo, de forma que o SO só precisa olhar o
+//   primeiro evento para saber se tem algum processo a desbloquear, e cada
+//   inserção ou remoção custa O(log n)
+//
+// a agenda não sabe nada sobre os processos, guarda só o pid; se um processo
+//   morrer ou for desbloqueado por outro motivo, o evento correspondente
+//   continua na agenda, e cabe a quem remove verificar se ele ainda vale
+
+#include <stdbool.h>
+
+typedef struct agenda_t agenda_t;
+
+// cria uma agenda vazia
+agenda_t *agenda_cria(void);
+
+// destrói uma agenda
+void agenda_destroi(agenda_t *self);
+
+// insere na agenda o desbloqueio do processo 'pid' na data 'data'
+void agenda_insere(agenda_t *self, int data, int pid);
+
+// retorna true se não houver evento na agenda
+bool agenda_vazia(agenda_t *self);
+
+// retorna a data do próximo evento (o de menor data)
+// a agenda não pode estar vazia
+int agenda_proxima_data(agenda_t *self);
+
+// remove o próximo evento da agenda, retorna o pid dele e coloca a data
+//   em '*pdata'
+// a agenda não pode estar vazia
+int agenda_remove(agenda_t *self, int *pdata);
+
+#endif // AGENDA_H
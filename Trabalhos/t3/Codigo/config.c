@@ -0,0 +1,148 @@
+// config.c
+// configuração da simulação, escolhida na execução
+// simulador de computador
+// so25b
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+
+// as opções aceitas, com o campo de config_t que cada uma altera
+typedef enum { INTEIRO, LOGICO, TEXTO } tipo_opcao_t;
+
+typedef struct {
+  char *nome;
+  tipo_opcao_t tipo;
+  size_t campo;  // deslocamento do campo em config_t
+  int min;       // menor valor aceito (inteiros)
+  char *descricao;
+} opcao_t;
+
+static opcao_t opcoes[] = {
+  { "mem",         INTEIRO, offsetof(config_t, mem_tam),               100,
+    "tamanho da memória principal, em palavras" },
+  { "mem2",        INTEIRO, offsetof(config_t, mem2_tam),              100,
+    "tamanho da memória secundária, em palavras" },
+  { "pagina",      INTEIRO, offsetof(config_t, tam_pagina),            1,
+    "tamanho da página, em palavras (rápido se for potência de 2)" },
+  { "swap",        INTEIRO, offsetof(config_t, tempo_swap),            0,
+    "tempo de transferência de uma página, em instruções" },
+  { "quantum",     INTEIRO, offsetof(config_t, quantum),               1,
+    "quantum, em interrupções do relógio" },
+  { "intervalo",   INTEIRO, offsetof(config_t, intervalo_interrupcao), 1,
+    "intervalo entre interrupções do relógio, em instruções" },
+  { "escalonador", INTEIRO, offsetof(config_t, escalonador),           SEM_ESCALONADOR,
+    "1 round-robin, 2 prioridade" },
+  { "console",     LOGICO,  offsetof(config_t, console),               0,
+    "0 para executar sem a tela" },
+  { "historico",   INTEIRO, offsetof(config_t, historico),             1,
+    "linhas de mensagens guardadas para rolar na console" },
+  { "limite",      INTEIRO, offsetof(config_t, limite),                0,
+    "sem console, termina nesta data do relógio (0 sem limite)" },
+  { "saida",       TEXTO,   offsetof(config_t, saida),                 0,
+    "prefixo do nome dos arquivos gerados" },
+  { "init",        TEXTO,   offsetof(config_t, init),                  0,
+    "programa executado pelo primeiro processo" },
+  { "perfil",      INTEIRO, offsetof(config_t, perfil),                0,
+    "amostra a execução a cada n instruções (0 sem perfil)" },
+  { "amostras",    INTEIRO, offsetof(config_t, intervalo_amostras),    1,
+    "intervalo entre amostras das estatísticas, em instruções" },
+  { "imagens",     INTEIRO, offsetof(config_t, orcamento_imagens),     0,
+    "memória para imagens de programas no SO, em palavras (0 sem cache)" },
+  { "roteiro",     TEXTO,   offsetof(config_t, roteiro),               0,
+    "arquivo com comandos para a console, com a data de cada um" },
+};
+#define N_OPCOES (int)(sizeof(opcoes) / sizeof(opcoes[0]))
+
+void config_inicializa(config_t *self)
+{
+  self->mem_tam = 1000;
+  self->mem2_tam = 10000;
+  self->tam_pagina = 10;
+  self->tempo_swap = 0;
+  self->quantum = 10;
+  self->intervalo_interrupcao = 50;
+  self->escalonador = ROUND_ROBIN;
+  self->console = true;
+  self->historico = 1000;
+  self->limite = 0;
+  strcpy(self->saida, "");
+  strcpy(self->init, "init.maq");
+  self->perfil = 0;
+  self->intervalo_amostras = 1000;
+  self->orcamento_imagens = 2000;
+  strcpy(self->roteiro, "");
+}
+
+// converte 'txt' em inteiro, retorna false se não for um inteiro válido
+static bool le_inteiro(char *txt, int *pvalor)
+{
+  char *fim;
+  errno = 0;
+  long valor = strtol(txt, &fim, 10);
+  if (*txt == '\0' || *fim != '\0' || errno != 0 || valor != (int)valor) {
+    return false;
+  }
+  *pvalor = valor;
+  return true;
+}
+
+bool config_le_opcao(config_t *self, char *opcao)
+{
+  char *igual = strchr(opcao, '=');
+  if (igual == NULL) return false;
+  int tam_nome = igual - opcao;
+  char *txt = igual + 1;
+
+  for (int i = 0; i < N_OPCOES; i++) {
+    opcao_t *o = &opcoes[i];
+    if ((int)strlen(o->nome) != tam_nome || strncmp(o->nome, opcao, tam_nome) != 0) {
+      continue;
+    }
+    void *campo = (char *)self + o->campo;
+    int valor;
+    switch (o->tipo) {
+      case INTEIRO:
+        if (!le_inteiro(txt, &valor) || valor < o->min) return false;
+        *(int *)campo = valor;
+        return true;
+      case LOGICO:
+        if (!le_inteiro(txt, &valor)) return false;
+        *(bool *)campo = (valor != 0);
+        return true;
+      case TEXTO:
+        if (strlen(txt) >= TAM_TEXTO_CONFIG) return false;
+        strcpy(campo, txt);
+        return true;
+    }
+  }
+  return false;
+}
+
+void config_nome_arquivo(config_t *self, char *arquivo, char *nome, int tam)
+{
+  snprintf(nome, tam, "%s%s", self->saida, arquivo);
+}
+
+void config_imprime_opcoes(config_t *self, FILE *f)
+{
+  for (int i = 0; i < N_OPCOES; i++) {
+    opcao_t *o = &opcoes[i];
+    void *campo = (char *)self + o->campo;
+    switch (o->tipo) {
+      case INTEIRO:
+        fprintf(f, "  %s=%d", o->nome, *(int *)campo);
+        break;
+      case LOGICO:
+        fprintf(f, "  %s=%d", o->nome, *(bool *)campo ? 1 : 0);
+        break;
+      case TEXTO:
+        fprintf(f, "  %s=%s", o->nome, (char *)campo);
+        break;
+    }
+    fprintf(f, "\t%s\n", o->descricao);
+  }
+}
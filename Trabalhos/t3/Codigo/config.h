@@ -0,0 +1,77 @@
+// config.h
+// configuração da simulação, escolhida na execução
+// simulador de computador
+// so25b
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// os parâmetros que antes eram constantes de compilação (em main.c e so.c)
+//   são definidos na linha de comando do simulador, na forma nome=valor,
+//   por exemplo
+//     ./main mem=500 swap=20 escalonador=2
+// main passa a configuração para a criação do hardware e do SO
+//
+// com console=0, o simulador executa sem a tela: começa a execução sem
+//   esperar comando, termina quando todos os processos terminarem (ou
+//   quando o relógio passar do limite) e imprime na saída padrão um resumo
+//   dos resultados, em uma linha com pares nome=valor (é o que o programa
+//   experimentos usa para executar várias configurações)
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// escalonadores
+#define SEM_ESCALONADOR 0
+#define ROUND_ROBIN 1
+#define PRIORIDADE 2
+
+// tamanho máximo das opções com texto
+#define TAM_TEXTO_CONFIG 100
+
+typedef struct {
+  int mem_tam;               // tamanho da memória principal, em palavras
+  int mem2_tam;              // tamanho da memória secundária, em palavras
+  int tam_pagina;            // tamanho de uma página, em palavras (ver mmu.h)
+  int tempo_swap;            // tempo de transferência de uma página, em instruções
+  int quantum;               // em interrupções do relógio
+  int intervalo_interrupcao; // em instruções executadas
+  int escalonador;           // SEM_ESCALONADOR, ROUND_ROBIN ou PRIORIDADE
+  bool console;              // false para executar sem a tela
+  int historico;             // linhas de mensagens guardadas na console
+  int limite;                // sem console, termina quando o relógio passar
+                             //   deste valor (0 é sem limite)
+  // prefixo do nome dos arquivos gerados (relatório, log, estatísticas),
+  //   para que execuções simultâneas não escrevam nos mesmos arquivos
+  char saida[TAM_TEXTO_CONFIG];
+  // programa executado pelo primeiro processo
+  char init[TAM_TEXTO_CONFIG];
+  // intervalo de amostragem do perfil de execução, em instruções (0 sem
+  //   perfil, ver perfil.h)
+  int perfil;
+  // intervalo entre amostras da série temporal das estatísticas, em
+  //   instruções (ver estat.h)
+  int intervalo_amostras;
+  // memória máxima ocupada pelas imagens dos programas guardadas pelo SO,
+  //   em palavras (ver imagens.h)
+  int orcamento_imagens;
+  // arquivo com comandos executados pela console em datas marcadas, como
+  //   se fossem digitados pelo operador (vazio sem roteiro, ver console.h)
+  char roteiro[TAM_TEXTO_CONFIG];
+} config_t;
+
+// coloca em 'self' a configuração padrão
+void config_inicializa(config_t *self);
+
+// altera a configuração conforme 'opcao', na forma nome=valor
+// retorna false (e não altera nada) se a opção for inválida
+bool config_le_opcao(config_t *self, char *opcao);
+
+// coloca em 'nome' (com 'tam' bytes) o nome do arquivo 'arquivo' com o
+//   prefixo da configuração
+void config_nome_arquivo(config_t *self, char *arquivo, char *nome, int tam);
+
+// imprime em 'f' as opções aceitas, com o valor em 'self'
+void config_imprime_opcoes(config_t *self, FILE *f);
+
+#endif // CONFIG_H
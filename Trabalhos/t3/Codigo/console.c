@@ -10,12 +10,17 @@
 #include "console.h"
 #include "terminal.h"
 #include "tela.h"
+#include "registro.h"
+#include "depura.h"
+#include "rastro.h"
+#include "relogio.h"
 
 #include <string.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <time.h>
 #include <assert.h>
 
 
@@ -44,6 +49,12 @@
 // números de comandos para o controlador que podem ser guardados na console
 #define N_CMD_EXT 10
 
+// número máximo de vezes por segundo que a tela é redesenhada (0 é sem limite)
+#define QUADROS_POR_SEGUNDO 30
+
+// número máximo de comandos no roteiro (ver console_le_roteiro)
+#define MAX_ROTEIRO 100
+
 
 // ---------------------------------------------------------------------
 // DECLARAÇÃO {{{1
@@ -54,10 +65,37 @@ struct console_t {
   int cor_txt[N_TERM];
   int cor_cursor[N_TERM];
   char txt_status[N_COL+1];
-  char txt_console[N_LIN_CONSOLE][N_COL+1];
+  // histórico das mensagens, em um buffer circular de n_lin_historico linhas
+  // hist_prox é a posição onde vai a próxima linha, hist_n quantas tem
+  // hist_volta é quantas linhas a área de mensagens está mostrando antes do
+  //   final do histórico (0 mostra as últimas)
+  char (*historico)[N_COL+1];
+  int n_lin_historico;
+  int hist_prox;
+  int hist_n;
+  int hist_volta;
   char txt_entrada[N_COL+1];
   char fila_de_comandos_externos[N_CMD_EXT];
-  FILE *arquivo_de_log;
+  registro_t *arquivo_de_log;
+  // o que mudou desde o último desenho, e precisa ser redesenhado
+  // as linhas dos terminais são comparadas com o que foi desenhado nelas
+  char txt_term_desenhado[N_LIN_TERM][N_COL+1];
+  bool status_alterado;
+  bool console_alterada[N_LIN_CONSOLE];
+  bool entrada_alterada;
+  // limite de desenhos por segundo, e o momento do último (em segundos,
+  //   no relógio do computador hospedeiro)
+  int quadros_por_segundo;
+  double momento_ultimo_desenho;
+  // false se a console não usa a tela (nem o teclado)
+  bool com_tela;
+  // comandos do roteiro, em ordem de data, e o próximo a executar
+  struct {
+    int data;
+    char cmd[N_COL+1];
+  } roteiro[MAX_ROTEIRO];
+  int n_roteiro;
+  int prox_roteiro;
 };
 
 
@@ -66,7 +104,7 @@ struct console_t {
 // ---------------------------------------------------------------------
 
 static console_t *console_global; // gambiarra para simplificar o uso de prints na console
-console_t *console_cria(void)
+console_t *console_cria(bool com_tela, char *nome_log, int n_lin_historico)
 {
   console_t *self = malloc(sizeof(*self));
   assert(self != NULL);
@@ -82,14 +120,41 @@ console_t *console_cria(void)
       self->cor_cursor[t] = COR_CURSOR_IMPAR;
     }
   }
+  // o histórico tem que ter pelo menos as linhas mostradas na console
+  if (n_lin_historico < N_LIN_CONSOLE) n_lin_historico = N_LIN_CONSOLE;
+  self->n_lin_historico = n_lin_historico;
+  self->historico = malloc(n_lin_historico * sizeof(*self->historico));
+  assert(self->historico != NULL);
+  self->hist_prox = 0;
+  self->hist_n = 0;
+  self->hist_volta = 0;
   for (int l = 0; l < N_LIN_CONSOLE; l++) {
-    strcpy(self->txt_console[l], "");
+    self->console_alterada[l] = true;
   }
   strcpy(self->txt_entrada, "");
+  strcpy(self->txt_status, "");
+  // força o desenho de tudo na primeira vez
+  for (int l = 0; l < N_LIN_TERM; l++) {
+    strcpy(self->txt_term_desenhado[l], "?");
+  }
+  self->status_alterado = true;
+  self->entrada_alterada = true;
+  self->quadros_por_segundo = QUADROS_POR_SEGUNDO;
+  self->momento_ultimo_desenho = 0;
   self->fila_de_comandos_externos[0] = '\0';
-  self->arquivo_de_log = fopen("log_da_console", "w");
-
-  tela_init();
+  self->arquivo_de_log = registro_cria(nome_log);
+  self->n_roteiro = 0;
+  self->prox_roteiro = 0;
+
+  self->com_tela = com_tela;
+  if (com_tela) {
+    tela_init();
+  } else {
+    // ninguém vai esperar pela saída dos terminais
+    for (int t = 0; t < N_TERM; t++) {
+      terminal_define_rapido(self->term[t], true);
+    }
+  }
 
   return self;
 }
@@ -98,18 +163,30 @@ static void console_desenha(console_t *self);
 
 void console_destroi(console_t *self)
 {
-  console_desenha(self);
-  if (self->arquivo_de_log != NULL) fclose(self->arquivo_de_log);
-  tela_puts(COR_OCUPADO, "  digite ENTER para sair  ");
-  tela_atualiza();
-  while (tela_tecla() != '\n') {
-    ;
+  if (self->com_tela) {
+    console_desenha(self);
+  } else {
+    // sem tela, o que ficou na saída dos terminais só aparece no log
+    for (int t = 0; t < N_TERM; t++) {
+      char *saida = terminal_txt_saida(self->term[t]);
+      if (*saida != '\0') console_printf("Terminal %c: '%s'", 'A' + t, saida);
+    }
+  }
+  // espera a escrita de todo o log
+  if (self->arquivo_de_log != NULL) registro_destroi(self->arquivo_de_log);
+  if (self->com_tela) {
+    tela_puts(COR_OCUPADO, "  digite ENTER para sair  ");
+    tela_atualiza();
+    while (tela_tecla() != '\n') {
+      ;
+    }
+    tela_fim();
   }
-  tela_fim();
 
   for (int t = 0; t < N_TERM; t++) {
     terminal_destroi(self->term[t]);
   }
+  free(self->historico);
   free(self);
   return;
 }
@@ -126,6 +203,14 @@ terminal_t *console_terminal(console_t *self, char id_terminal)
   return self->term[num_terminal];
 }
 
+bool console_tem_interrupcao(console_t *self, int id)
+{
+  for (int t = 0; t < N_TERM; t++) {
+    if (terminal_tem_interrupcao(self->term[t], id)) return true;
+  }
+  return false;
+}
+
 static void atualiza_terminais(console_t *self)
 {
   for (int t = 0; t < N_TERM; t++) {
@@ -135,7 +220,7 @@ static void atualiza_terminais(console_t *self)
 
 static void insere_string_no_terminal(console_t *self, char id_terminal, char *str)
 {
-  // insere caracteres no terminal (e espaço no final)
+  // insere caracteres no terminal (e fim de linha no final)
   terminal_t *terminal = console_terminal(self, id_terminal);
   if (terminal == NULL) {
     console_printf("Terminal '%c' inválido\n", id_terminal);
@@ -146,7 +231,7 @@ static void insere_string_no_terminal(console_t *self, char id_terminal, char *s
     terminal_insere_char(terminal, *p);
     p++;
   }
-  terminal_insere_char(terminal, ' ');
+  terminal_insere_char(terminal, '\n');
 }
 
 static void limpa_saida_do_terminal(console_t *self, char id_terminal)
@@ -164,16 +249,64 @@ static void limpa_saida_do_terminal(console_t *self, char id_terminal)
 // SAÍDA {{{1
 // ---------------------------------------------------------------------
 
+// número máximo de linhas que dá para voltar no histórico
+static int max_volta(console_t *self)
+{
+  int max = self->hist_n - N_LIN_CONSOLE;
+  return max > 0 ? max : 0;
+}
+
+// retorna a linha do histórico que aparece na linha 'l' da área de mensagens
+static char *linha_da_console(console_t *self, int l)
+{
+  // índice no histórico, 0 é a linha mais antiga ainda guardada
+  int i = self->hist_n - N_LIN_CONSOLE - self->hist_volta + l;
+  if (i < 0) return "";
+  int pos = (self->hist_prox - self->hist_n + i + self->n_lin_historico)
+            % self->n_lin_historico;
+  return self->historico[pos];
+}
+
+static void marca_console_alterada(console_t *self)
+{
+  for (int l = 0; l < N_LIN_CONSOLE; l++) {
+    self->console_alterada[l] = true;
+  }
+}
+
+// volta 'n' linhas no histórico (avança se negativo); 0 vai para o final
+static void rola_historico(console_t *self, int n)
+{
+  if (n == 0) {
+    self->hist_volta = 0;
+  } else {
+    self->hist_volta += n;
+  }
+  if (self->hist_volta < 0) self->hist_volta = 0;
+  if (self->hist_volta > max_volta(self)) self->hist_volta = max_volta(self);
+  marca_console_alterada(self);
+}
+
 static void insere_string_na_console(console_t *self, char *s)
 {
-  for(int l=0; l<N_LIN_CONSOLE-1; l++) {
-    strncpy(self->txt_console[l], self->txt_console[l+1], N_COL);
-    self->txt_console[l][N_COL] = '\0'; // quem definiu strncpy é estúpido!
+  // coloca a linha no lugar da mais antiga, sem mexer nas outras
+  char *linha = self->historico[self->hist_prox];
+  strncpy(linha, s, N_COL);
+  linha[N_COL] = '\0'; // quem definiu strncpy é estúpido!
+  self->hist_prox = (self->hist_prox + 1) % self->n_lin_historico;
+  if (self->hist_n < self->n_lin_historico) self->hist_n++;
+  if (self->hist_volta == 0) {
+    // as linhas mostradas subiram
+    marca_console_alterada(self);
+  } else if (self->hist_volta < max_volta(self)) {
+    // voltando no histórico: continua mostrando as mesmas linhas
+    self->hist_volta++;
+  } else {
+    // a primeira linha mostrada foi sobrescrita
+    marca_console_alterada(self);
   }
-  strncpy(self->txt_console[N_LIN_CONSOLE-1], s, N_COL);
-  self->txt_console[N_LIN_CONSOLE-1][N_COL] = '\0'; // grrrr
   if (self->arquivo_de_log != NULL) {
-    fprintf(self->arquivo_de_log, "%s\n", s);
+    registro_linha(self->arquivo_de_log, s);
   }
 }
 
@@ -195,7 +328,12 @@ static void insere_strings_na_console(console_t *self, char *s)
 void console_print_status(console_t *self, char *txt)
 {
   // imprime alinhado a esquerda ("-"), max N_COL chars ("*")
-  sprintf(self->txt_status, "%-*s", N_COL, txt);
+  char novo[N_COL+1];
+  snprintf(novo, sizeof(novo), "%-*s", N_COL, txt);
+  if (strcmp(novo, self->txt_status) != 0) {
+    strcpy(self->txt_status, novo);
+    self->status_alterado = true;
+  }
 }
 
 int console_printf(char *formato, ...)
@@ -204,7 +342,7 @@ int console_printf(char *formato, ...)
   // Se não sabe como é isso, dá uma olhada em:
   // https://www.geeksforgeeks.org/variadic-functions-in-c/
   console_t *self = console_global; // gambiarra para simplificar o uso de prints na console
-  char s[sizeof(self->txt_console)];
+  char s[N_LIN_CONSOLE * (N_COL+1)];
   va_list arg;
   va_start(arg, formato);
   int r = vsnprintf(s, sizeof(s), formato, arg);
@@ -236,19 +374,24 @@ static char remove_comando_externo(console_t *self)
   return cmd;
 }
 
-static void interpreta_linha_entrada(console_t *self)
+static void interpreta_comando(console_t *self, char *linha)
 {
-  // interpreta uma linha digitada pelo operador
+  // interpreta um comando digitado pelo operador (ou do roteiro)
   // Comandos aceitos:
   // Etstr entra a string 'str' no terminal 't'  ex: eb30
   // Zt    esvazia a saída do terminal 't'  ex: za
   // Dn    altera o tempo de espera do teclado  ex: d0  -> modo turbo
+  // Rn    liga (1) ou desliga (0) o modo rápido dos terminais  ex: r1
+  // Lsn   muda para n o nível das mensagens do subsistema s (ou * para todos)
+  //       ex: lm3 (detalhes da memória)
+  // Sn    volta n linhas nas mensagens (avança se negativo, S0 vai pro fim)  ex: s10
+  // Qn    desenha a tela no máximo n vezes por segundo (0 sem limite)  ex: q10
+  // T     grava o rastro de eventos do SO (ver rastro.h)
   // P     para a execução
   // 1     executa uma instrução
   // C     continua a execução
   // F     fim da simulação
 
-  char *linha = self->txt_entrada;
   console_printf("CMD: '%s'", linha);
   char cmd = toupper(linha[0]);
   int val;
@@ -263,6 +406,31 @@ static void interpreta_linha_entrada(console_t *self)
       val = atoi(&linha[1]);
       tela_espera(val);
       break;
+    case 'L':
+      if (linha[1] == '\0' || !depura_define_nivel(linha[1], atoi(&linha[2]))) {
+        console_printf("Subsistema '%c' inválido (use i p m c e ou *)", linha[1]);
+      }
+      break;
+    case 'S':
+      rola_historico(self, atoi(&linha[1]));
+      break;
+    case 'Q':
+      val = atoi(&linha[1]);
+      self->quadros_por_segundo = (val > 0) ? val : 0;
+      break;
+    case 'T':
+      if (rastro_grava()) {
+        console_printf("Rastro gravado em '%s'", rastro_nome_arquivo());
+      } else {
+        console_printf("Erro na gravação do rastro em '%s'", rastro_nome_arquivo());
+      }
+      break;
+    case 'R':
+      val = atoi(&linha[1]);
+      for (int t = 0; t < N_TERM; t++) {
+        terminal_define_rapido(self->term[t], val != 0);
+      }
+      break;
     case 'P':
     case '1':
     case 'C':
@@ -272,12 +440,67 @@ static void interpreta_linha_entrada(console_t *self)
     default:
       console_printf("Comando '%c' não reconhecido", cmd);
   }
+}
+
+static void interpreta_linha_entrada(console_t *self)
+{
+  interpreta_comando(self, self->txt_entrada);
   strcpy(self->txt_entrada, "");
+  self->entrada_alterada = true;
+}
+
+// executa os comandos do roteiro que já chegaram na data
+static void executa_roteiro(console_t *self)
+{
+  while (self->prox_roteiro < self->n_roteiro
+         && self->roteiro[self->prox_roteiro].data <= relogio_agora()) {
+    interpreta_comando(self, self->roteiro[self->prox_roteiro].cmd);
+    self->prox_roteiro++;
+  }
+}
+
+bool console_le_roteiro(console_t *self, char *nome)
+{
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) {
+    fprintf(stderr, "Erro na abertura do roteiro '%s'\n", nome);
+    return false;
+  }
+  char linha[N_COL + 20];
+  int num_linha = 0;
+  bool ok = true;
+  while (ok && fgets(linha, sizeof(linha), arq) != NULL) {
+    num_linha++;
+    linha[strcspn(linha, "\n")] = '\0';
+    if (linha[0] == '\0' || linha[0] == '#') continue;
+    int data;
+    int pos;
+    if (sscanf(linha, "%d %n", &data, &pos) != 1 || linha[pos] == '\0'
+        || strlen(&linha[pos]) > N_COL) {
+      fprintf(stderr, "%s:%d: linha inválida no roteiro\n", nome, num_linha);
+      ok = false;
+    } else if (self->n_roteiro > 0
+               && data < self->roteiro[self->n_roteiro - 1].data) {
+      fprintf(stderr, "%s:%d: data fora de ordem no roteiro\n", nome, num_linha);
+      ok = false;
+    } else if (self->n_roteiro >= MAX_ROTEIRO) {
+      fprintf(stderr, "%s:%d: roteiro com mais de %d comandos\n", nome,
+              num_linha, MAX_ROTEIRO);
+      ok = false;
+    } else {
+      self->roteiro[self->n_roteiro].data = data;
+      strcpy(self->roteiro[self->n_roteiro].cmd, &linha[pos]);
+      self->n_roteiro++;
+    }
+  }
+  fclose(arq);
+  return ok;
 }
 
 // lê e guarda um caractere do teclado; interpreta linha se for 'enter'
 static void verifica_entrada(console_t *self)
 {
+  if (!self->com_tela) return;
   char ch = tela_tecla();
 
   int l = strlen(self->txt_entrada);
@@ -285,12 +508,14 @@ static void verifica_entrada(console_t *self)
   if (ch == '\b' || ch == 127) {   // backspace ou del
     if (l > 0) {
       self->txt_entrada[l - 1] = '\0';
+      self->entrada_alterada = true;
     }
   } else if (ch == '\n') {
     interpreta_linha_entrada(self);
   } else if (ch >= ' ' && ch < 127 && l < N_COL) {
     self->txt_entrada[l] = ch;
     self->txt_entrada[l+1] = '\0';
+    self->entrada_alterada = true;
   } // senão, ignora o caractere digitado
 }
 
@@ -300,15 +525,33 @@ char console_comando_externo(console_t *self)
   return remove_comando_externo(self);
 }
 
+void console_insere_comando(console_t *self, char cmd)
+{
+  insere_comando_externo(self, cmd);
+}
+
 
 // ---------------------------------------------------------------------
 // DESENHO {{{1
 // ---------------------------------------------------------------------
 
-static void desenha_linha_terminal(char *txt, int linha, int cor_txt, int cor_cursor)
+// desenha a linha 'linha' de um terminal, se ela mudou desde o último desenho
+static void desenha_linha_terminal(console_t *self, char *txt, int linha,
+                                   int cor_txt, int cor_cursor)
 {
+  // caracteres de controle (como o fim de linha da entrada) são desenhados
+  //   como espaço, para não bagunçar a tela
+  char visivel[N_COL + 1];
+  int n;
+  for (n = 0; n < N_COL && txt[n] != '\0'; n++) {
+    visivel[n] = (txt[n] >= 0 && txt[n] < ' ') ? ' ' : txt[n];
+  }
+  visivel[n] = '\0';
+  char *desenhado = self->txt_term_desenhado[linha - LINHA_TERM];
+  if (strcmp(visivel, desenhado) == 0) return;
+  strcpy(desenhado, visivel);
   tela_posiciona(linha, 0);
-  tela_puts(cor_txt, txt);
+  tela_puts(cor_txt, visivel);
   tela_limpa_linha();
   tela_puts(cor_cursor, " ");
 }
@@ -320,13 +563,15 @@ static void desenha_terminais(console_t *self)
     int cor_txt = self->cor_txt[t];
     int cor_cursor = self->cor_cursor[t];
     int linha = LINHA_TERM + t * 2;
-    desenha_linha_terminal(terminal_txt_entrada(terminal), linha, cor_txt, cor_cursor);
-    desenha_linha_terminal(terminal_txt_saida(terminal), linha+1, cor_txt, cor_cursor);
+    desenha_linha_terminal(self, terminal_txt_entrada(terminal), linha, cor_txt, cor_cursor);
+    desenha_linha_terminal(self, terminal_txt_saida(terminal), linha+1, cor_txt, cor_cursor);
   }
 }
 
 static void desenha_status(console_t *self)
 {
+  if (!self->status_alterado) return;
+  self->status_alterado = false;
   tela_posiciona(LINHA_STATUS, 0);
   tela_puts(COR_STATUS, self->txt_status);
   tela_limpa_linha();
@@ -335,14 +580,18 @@ static void desenha_status(console_t *self)
 static void desenha_console(console_t *self)
 {
   for (int l=0; l<N_LIN_CONSOLE; l++) {
+    if (!self->console_alterada[l]) continue;
+    self->console_alterada[l] = false;
     tela_posiciona(LINHA_CONSOLE + l, 0);
-    tela_puts(COR_CONSOLE, self->txt_console[l]);
+    tela_puts(COR_CONSOLE, linha_da_console(self, l));
     tela_limpa_linha();
   }
 }
 
 static void desenha_entrada(console_t *self)
 {
+  if (!self->entrada_alterada) return;
+  self->entrada_alterada = false;
   char txt_fixo[] = "P=para C=continua 1=passo F=fim  Ets=entra Zt=zera";
   tela_posiciona(LINHA_ENTRADA, 0);
   tela_puts(COR_ENTRADA, ""); // gambiarra para limpar na cor certa
@@ -353,17 +602,40 @@ static void desenha_entrada(console_t *self)
   tela_puts(COR_ENTRADA, self->txt_entrada);
 }
 
+// redesenha só as partes da tela que mudaram
 static void console_desenha(console_t *self)
 {
   desenha_terminais(self);
   desenha_status(self);
   desenha_console(self);
   desenha_entrada(self);
+  // deixa o cursor no final da linha de entrada
+  tela_posiciona(LINHA_ENTRADA, strlen(self->txt_entrada));
 
   // faz aparecer tudo que foi desenhado
   tela_atualiza();
 }
 
+// retorna o tempo atual do computador hospedeiro, em segundos
+static double agora_em_segundos(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// retorna true se já passou tempo suficiente desde o último desenho
+static bool hora_de_desenhar(console_t *self)
+{
+  if (self->quadros_por_segundo <= 0) return true;
+  double agora = agora_em_segundos();
+  if (agora - self->momento_ultimo_desenho < 1.0 / self->quadros_por_segundo) {
+    return false;
+  }
+  self->momento_ultimo_desenho = agora;
+  return true;
+}
+
 
 // ---------------------------------------------------------------------
 // TICTAC {{{1
@@ -371,9 +643,10 @@ static void console_desenha(console_t *self)
 
 void console_tictac(console_t *self)
 {
+  executa_roteiro(self);
   verifica_entrada(self);
   atualiza_terminais(self);
-  console_desenha(self);
+  if (self->com_tela && hora_de_desenhar(self)) console_desenha(self);
 }
 
 // vim: foldmethod=marker
@@ -12,7 +12,26 @@
 typedef struct console_t console_t;
 
 // cria e inicializa a console
-console_t *console_cria(void);
+// as mensagens são registradas no arquivo 'nome_log'
+// as últimas 'n_lin_historico' linhas de mensagens ficam guardadas, e podem
+//   ser vistas voltando na área de mensagens (comando S); o histórico tem
+//   pelo menos as linhas que cabem na área de mensagens
+// se 'com_tela' for false, a console não usa a tela nem o teclado: os
+//   comandos externos são só os inseridos com console_insere_comando, e os
+//   terminais ficam no modo rápido; o que estiver na saída dos terminais no
+//   final é registrado no log
+console_t *console_cria(bool com_tela, char *nome_log, int n_lin_historico);
+
+// lê do arquivo 'nome' um roteiro de comandos, que são executados como se
+//   tivessem sido digitados pelo operador (ver interpreta_comando em
+//   console.c), cada um quando o relógio chegar na sua data
+// cada linha do arquivo tem a data e o comando, por exemplo
+//     3000 eaabc
+//   entra a linha "abc" no terminal A quando o relógio chegar em 3000
+// as datas devem estar em ordem; linhas vazias ou começando com '#' são
+//   ignoradas
+// retorna false (com uma mensagem em stderr) em caso de erro
+bool console_le_roteiro(console_t *self, char *nome);
 
 // destrói a console
 void console_destroi(console_t *self);
@@ -34,9 +53,16 @@ void console_print_status(console_t *self, char *txt);
 // retorna '\0' caso não tenha comando externo digitado
 char console_comando_externo(console_t *self);
 
+// insere um comando externo, como se tivesse sido digitado pelo operador
+void console_insere_comando(console_t *self, char cmd);
+
 // retorna o terminal identificado ('A', 'B', etc)
 terminal_t *console_terminal(console_t *self, char id_terminal);
 
+// retorna true se algum terminal estiver pedindo interrupção do tipo 'id'
+//   (TERM_TECLADO ou TERM_TELA, ver terminal_tem_interrupcao)
+bool console_tem_interrupcao(console_t *self, int id);
+
 // esta função deve ser chamada periodicamente para que tela funcione
 void console_tictac(console_t *self);
 
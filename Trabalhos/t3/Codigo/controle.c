@@ -4,7 +4,7 @@
 // so25b
 
 #include "controle.h"
-#include "metricas.h"
+#include "cronometro.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -46,43 +46,12 @@ void controle_laco(controle_t *self)
   // executa uma instrução por vez até a console dizer que chega
   do {
     if (self->estado == passo || self->estado == executando) {
+      CRONOMETRO_INICIO(t_cpu);
       cpu_executa_1(self->cpu);
+      CRONOMETRO_FIM(CRONO_CPU, t_cpu);
+      CRONOMETRO_INICIO(t_relogio);
       relogio_tictac(self->relogio);
-
-      // (metricas) calcula tempo ocioso
-      metricas.tempo_total_execucao++;
-      if (metricas.so_oscioso){
-        metricas.tempo_total_ocioso++;
-      }
-      // (metricas) processos
-      for (int i = 0; i < 5; i++){
-        // guarda o tempo de criação de um processo
-        if (metricas.processos_recem_criado[i]){
-          metricas.tempo_criacao[i] = metricas.tempo_total_execucao;
-          metricas.processos_recem_criado[i] = false;
-        }
-        // metricas do tempo em cada estado
-        switch (metricas.processos_estado[i]){
-          case 0:  // pronto
-            metricas.tempo_pronto[i]++;
-            break;
-          case 1:  // execução
-            metricas.tempo_execucao[i]++;
-            break;
-          case 2:  // espera
-            // não foi pedido
-            break;
-          case 3:  // bloqueado
-            metricas.tempo_bloqueado[i]++;
-            break;
-          default:  // finalizado
-            if (!metricas.final_ja_registrado[i]){
-              metricas.tempo_retorno_processo[i] = metricas.tempo_total_execucao - metricas.tempo_criacao[i];
-              console_printf("TEMPO DE RETORNO: %d - %d", metricas.tempo_total_execucao, metricas.tempo_criacao[i]);
-              metricas.final_ja_registrado[i] = true;
-            }
-        }
-      }
+      CRONOMETRO_FIM(CRONO_RELOGIO, t_relogio);
 
       if (self->estado == passo) self->estado = parado;
 
@@ -93,11 +62,24 @@ void controle_laco(controle_t *self)
       if (tem_int != 0) {
         cpu_interrompe(self->cpu, IRQ_RELOGIO);
       }
+      // os terminais pedem interrupção quando chega entrada ou a saída libera
+      // se a CPU não aceitar agora (está tratando outra), tenta de novo na
+      //   próxima volta do laço, o pedido continua ativo no terminal
+      CRONOMETRO_INICIO(t_terminais);
+      bool int_teclado = console_tem_interrupcao(self->console, TERM_TECLADO);
+      bool int_tela = console_tem_interrupcao(self->console, TERM_TELA);
+      CRONOMETRO_FIM(CRONO_TERMINAIS, t_terminais);
+      if (int_teclado) cpu_interrompe(self->cpu, IRQ_TECLADO);
+      if (int_tela) cpu_interrompe(self->cpu, IRQ_TELA);
     }
+    CRONOMETRO_INICIO(t_console);
     console_tictac(self->console);
+    CRONOMETRO_FIM(CRONO_CONSOLE, t_console);
 
+    CRONOMETRO_INICIO(t_status);
     controle_processa_comandos_da_console(self);
     controle_atualiza_estado_na_console(self);
+    CRONOMETRO_FIM(CRONO_STATUS, t_status);
   } while (self->estado != fim);
 
   console_printf("Fim da execução.");
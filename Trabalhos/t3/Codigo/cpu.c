@@ -40,6 +40,14 @@ struct cpu_t {
   // função e argumento para implementar instrução CHAMAC
   func_chamaC_t func_chamaC;
   void *arg_chamaC;
+  // função e argumento para a amostragem, e instruções até a próxima amostra
+  func_amostra_t func_amostra;
+  void *arg_amostra;
+  int amostra_intervalo;
+  int amostra_falta;
+  // contadores de desempenho, e o escolhido para leitura como dispositivo
+  cpu_contadores_t cont;
+  int contador_sel;
 };
 
 
@@ -65,12 +73,16 @@ cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
   self->complemento = 0;
   self->modo = supervisor;
   self->func_chamaC = NULL;
+  self->func_amostra = NULL;
+  memset(&self->cont, 0, sizeof(self->cont));
+  self->contador_sel = 0;
+  assert(CPU_N_CONT <= CPU_CONT_PARTE_ALTA);
 
   // inicializa instruções privilegiadas
+  // LE e ESCR são privilegiadas menos para os dispositivos liberados para o
+  //   modo usuário, e são verificadas na execução (ver op_LE e op_ESCR)
   memset(self->privilegiadas, 0, sizeof(self->privilegiadas)); // todos em false
   self->privilegiadas[PARA] = true;
-  self->privilegiadas[LE] = true;
-  self->privilegiadas[ESCR] = true;
   self->privilegiadas[RETI] = true;
   self->privilegiadas[CHAMAC] = true;
 
@@ -89,6 +101,56 @@ void cpu_define_chamaC(cpu_t *self, func_chamaC_t func_chamaC, void *arg_chamaC)
   self->arg_chamaC = arg_chamaC;
 }
 
+cpu_contadores_t *cpu_contadores(cpu_t *self)
+{
+  return &self->cont;
+}
+
+// retorna o valor do contador número 'n' (ver cpu.h)
+static long cpu_valor_contador(cpu_t *self, int n)
+{
+  cpu_contadores_t *c = &self->cont;
+  if (n >= CPU_CONT_INSTRUCAO && n < CPU_CONT_MODO) return c->instrucoes[n - CPU_CONT_INSTRUCAO];
+  if (n >= CPU_CONT_MODO && n < CPU_CONT_LEITURAS) return c->modo[n - CPU_CONT_MODO];
+  if (n == CPU_CONT_LEITURAS) return c->leituras;
+  if (n == CPU_CONT_ESCRITAS) return c->escritas;
+  if (n == CPU_CONT_DESVIOS_TOMADOS) return c->desvios_tomados;
+  if (n == CPU_CONT_DESVIOS_NAO_TOMADOS) return c->desvios_nao_tomados;
+  return c->irqs[n - CPU_CONT_IRQ];
+}
+
+err_t cpu_leitura_contador(void *disp, int id, int *pvalor)
+{
+  cpu_t *self = disp;
+  if (id == 0) {
+    *pvalor = self->contador_sel;
+  } else {
+    int n = self->contador_sel;
+    unsigned long valor = cpu_valor_contador(self, n % CPU_CONT_PARTE_ALTA);
+    if (n >= CPU_CONT_PARTE_ALTA) valor >>= 32;
+    *pvalor = (unsigned int)valor;
+  }
+  return ERR_OK;
+}
+
+err_t cpu_escrita_contador(void *disp, int id, int valor)
+{
+  cpu_t *self = disp;
+  if (id != 0) return ERR_OP_INV;
+  if (valor < 0 || valor >= 2 * CPU_CONT_PARTE_ALTA) return ERR_OP_INV;
+  if (valor % CPU_CONT_PARTE_ALTA >= CPU_N_CONT) return ERR_OP_INV;
+  self->contador_sel = valor;
+  return ERR_OK;
+}
+
+void cpu_define_amostragem(cpu_t *self, int intervalo, func_amostra_t func, void *arg)
+{
+  self->func_amostra = (intervalo > 0) ? func : NULL;
+  self->arg_amostra = arg;
+  self->amostra_intervalo = intervalo;
+  self->amostra_falta = intervalo;
+}
+
 
 // ---------------------------------------------------------------------
 // DESCRIÇÃO {{{1
@@ -154,8 +216,12 @@ void cpu_concatena_descricao(cpu_t *self, char *str)
 static bool pega_mem(cpu_t *self, int endereco, int *pval)
 {
   // não tem que testar endereços, é tarefa da mmu
+  // só conta o acesso que deu certo (o que causou falta de página é refeito)
   self->erro = mmu_le(self->mmu, endereco, pval, self->modo);
-  if (self->erro == ERR_OK) return true;
+  if (self->erro == ERR_OK) {
+    self->cont.leituras++;
+    return true;
+  }
   self->complemento = endereco;
   return false;
 }
@@ -165,7 +231,10 @@ static bool poe_mem(cpu_t *self, int endereco, int val)
 {
   // não tem que testar endereços, é tarefa da mmu
   self->erro = mmu_escreve(self->mmu, endereco, val, self->modo);
-  if (self->erro == ERR_OK) return true;
+  if (self->erro == ERR_OK) {
+    self->cont.escritas++;
+    return true;
+  }
   self->complemento = endereco;
   return false;
 }
@@ -349,40 +418,38 @@ static void op_DESV(cpu_t *self) // desvio incondicional
   }
 }
 
-static void op_DESVZ(cpu_t *self) // desvio condicional
+// desvia se 'condicao' for verdadeira
+// o desvio tomado só é contado se der certo (o argumento pode causar falta de
+//   página, e a instrução é executada de novo)
+static void desvio_condicional(cpu_t *self, bool condicao)
 {
-  if (self->A == 0) {
+  if (condicao) {
     op_DESV(self);
+    if (self->erro == ERR_OK) self->cont.desvios_tomados++;
   } else {
+    self->cont.desvios_nao_tomados++;
     self->PC += 2;
   }
 }
 
+static void op_DESVZ(cpu_t *self) // desvio condicional
+{
+  desvio_condicional(self, self->A == 0);
+}
+
 static void op_DESVNZ(cpu_t *self) // desvio condicional
 {
-  if (self->A != 0) {
-    op_DESV(self);
-  } else {
-    self->PC += 2;
-  }
+  desvio_condicional(self, self->A != 0);
 }
 
 static void op_DESVN(cpu_t *self) // desvio condicional
 {
-  if (self->A < 0) {
-    op_DESV(self);
-  } else {
-    self->PC += 2;
-  }
+  desvio_condicional(self, self->A < 0);
 }
 
 static void op_DESVP(cpu_t *self) // desvio condicional
 {
-  if (self->A > 0) {
-    op_DESV(self);
-  } else {
-    self->PC += 2;
-  }
+  desvio_condicional(self, self->A > 0);
 }
 
 static void op_CHAMA(cpu_t *self) // chamada de subrotina
@@ -401,10 +468,18 @@ static void op_RET(cpu_t *self) // retorno de subrotina
   }
 }
 
+// em modo usuário, só pode acessar os dispositivos liberados (ver es.h)
+static bool pode_acessar_es(cpu_t *self, int dispositivo)
+{
+  if (self->modo == supervisor || es_acesso_usuario(self->es, dispositivo)) return true;
+  self->erro = ERR_INSTR_PRIV;
+  return false;
+}
+
 static void op_LE(cpu_t *self) // leitura de E/S
 {
   int A1, dado;
-  if (pega_A1(self, &A1) && pega_es(self, A1, &dado)) {
+  if (pega_A1(self, &A1) && pode_acessar_es(self, A1) && pega_es(self, A1, &dado)) {
     self->A = dado;
     self->PC += 2;
   }
@@ -413,7 +488,7 @@ static void op_LE(cpu_t *self) // leitura de E/S
 static void op_ESCR(cpu_t *self) // escrita de E/S
 {
   int A1;
-  if (pega_A1(self, &A1) && poe_es(self, A1, self->A)) {
+  if (pega_A1(self, &A1) && pode_acessar_es(self, A1) && poe_es(self, A1, self->A)) {
     self->PC += 2;
   }
 }
@@ -453,6 +528,8 @@ static void op_CHAMAS(cpu_t *self) // chamada de sistema
 
 static void executa_a_instrucao(cpu_t *self, int opcode)
 {
+  // a instrução pode mudar o modo (RETI, CHAMAS)
+  cpu_modo_t modo = self->modo;
   switch (opcode) {
     case NOP:    op_NOP(self);    break;
     case PARA:   op_PARA(self);   break;
@@ -484,10 +561,21 @@ static void executa_a_instrucao(cpu_t *self, int opcode)
     case CHAMAS: op_CHAMAS(self); break;
     default:     self->erro = ERR_INSTR_INV;
   }
+  // só conta a instrução que terminou: a que causou erro (uma falta de página,
+  //   por exemplo) não foi executada, e vai ser executada de novo
+  if (self->erro != ERR_OK && self->erro != ERR_CPU_PARADA) return;
+  self->cont.instrucoes[opcode]++;
+  self->cont.modo[modo]++;
 }
 
 void cpu_executa_1(cpu_t *self)
 {
+  if (self->func_amostra != NULL && --self->amostra_falta <= 0) {
+    self->amostra_falta = self->amostra_intervalo;
+    self->func_amostra(self->arg_amostra, self->PC, self->modo,
+                       self->erro == ERR_CPU_PARADA);
+  }
+
   // não executa se CPU já estiver em erro
   if (self->erro != ERR_OK) return;
 
@@ -516,6 +604,7 @@ bool cpu_interrompe(cpu_t *self, irq_t irq)
 {
   // só aceita interrupção em modo usuário ou quando a CPU está dormindo
   if (self->modo != usuario && self->erro != ERR_CPU_PARADA) return false;
+  if (irq >= 0 && irq < N_IRQ) self->cont.irqs[irq]++;
 
   // Copia o estado da CPU para variáveis locais, para ter certeza que nada será
   //   alterado por funções auxiliares (poe_mem altera o erro)
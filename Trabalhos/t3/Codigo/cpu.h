@@ -33,10 +33,54 @@ typedef enum { supervisor, usuario } cpu_modo_t;
 #include "es.h"
 #include "irq.h"
 #include "mmu.h"
+#include "instrucao.h"
 
 // tipo da função a ser chamada quando executar a instrução CHAMAC
 typedef int (*func_chamaC_t)(void *argC, int reg_A);
 
+// contadores de desempenho da CPU (mistura de instruções), desde a criação
+// só contam as instruções e os acessos à memória que terminaram sem erro: a
+//   instrução que causa uma falta de página é contada uma vez só, quando é
+//   executada de novo
+typedef struct {
+  long instrucoes[N_OPCODE];  // execuções de cada opcode
+  long modo[2];               // instruções executadas em cada cpu_modo_t
+  long leituras;              // leituras da memória, inclusive busca de instruções
+  long escritas;              // escritas na memória, inclusive salvamento do
+                              //   estado em interrupções
+  long desvios_tomados;       // DESVZ, DESVNZ, DESVN e DESVP que desviaram
+  long desvios_nao_tomados;   // DESVZ, DESVNZ, DESVN e DESVP que não desviaram
+  long irqs[N_IRQ];           // interrupções aceitas, por irq_t
+} cpu_contadores_t;
+
+// os contadores também podem ser lidos pelos programas, pelos dispositivos
+//   D_CPU_CONTADOR_SEL e D_CPU_CONTADOR (ver dispositivos.h), que podem ser
+//   acessados em modo usuário: escreve-se em D_CPU_CONTADOR_SEL o número de
+//   um contador e lê-se o seu valor em D_CPU_CONTADOR
+// os contadores são da máquina, não de um processo: a diferença entre duas
+//   leituras inclui o que os outros processos executaram entre elas; o
+//   número escolhido em D_CPU_CONTADOR_SEL também não é salvo na troca de
+//   processo
+// numeração dos contadores nesses dispositivos:
+#define CPU_CONT_INSTRUCAO          0                             // + opcode
+#define CPU_CONT_MODO               (CPU_CONT_INSTRUCAO + N_OPCODE) // + cpu_modo_t
+#define CPU_CONT_LEITURAS           (CPU_CONT_MODO + 2)
+#define CPU_CONT_ESCRITAS           (CPU_CONT_LEITURAS + 1)
+#define CPU_CONT_DESVIOS_TOMADOS    (CPU_CONT_ESCRITAS + 1)
+#define CPU_CONT_DESVIOS_NAO_TOMADOS (CPU_CONT_DESVIOS_TOMADOS + 1)
+#define CPU_CONT_IRQ                (CPU_CONT_DESVIOS_NAO_TOMADOS + 1) // + irq_t
+#define CPU_N_CONT                  (CPU_CONT_IRQ + N_IRQ)
+// os contadores têm 64 bits, e D_CPU_CONTADOR tem 32: lê-se os 32 bits de
+//   baixo do contador n escolhendo n, e os 32 de cima escolhendo
+//   n + CPU_CONT_PARTE_ALTA (nos dois casos o valor lido é o padrão de bits,
+//   pode ser negativo); as duas partes são lidas separadamente, o contador
+//   pode mudar entre elas
+#define CPU_CONT_PARTE_ALTA         256
+
+// tipo da função chamada para amostrar a execução (ver cpu_define_amostragem)
+//   recebe o PC e o modo da CPU, e se ela está parada
+typedef void (*func_amostra_t)(void *arg, int PC, cpu_modo_t modo, bool parada);
+
 
 // cria uma unidade de execução com acesso à MMU e ao
 //   controlador de E/S fornecidos
@@ -62,6 +106,20 @@ bool cpu_interrompe(cpu_t *self, irq_t irq);
 // e o argumento a passar para ela (normalmente, um ponteiro para o SO)
 void cpu_define_chamaC(cpu_t *self, func_chamaC_t func, void *argC);
 
+// define a função a chamar a cada 'intervalo' chamadas de cpu_executa_1
+//   (inclusive com a CPU parada), antes da execução da instrução, e o
+//   argumento a passar para ela; com func NULL, não amostra
+// é usado pelo SO para o perfil de execução dos processos
+void cpu_define_amostragem(cpu_t *self, int intervalo, func_amostra_t func, void *arg);
+
+// retorna os contadores de desempenho da CPU
+cpu_contadores_t *cpu_contadores(cpu_t *self);
+
+// funções de acesso aos contadores como dispositivos de E/S (ver es.h)
+//   o id é 0 para D_CPU_CONTADOR_SEL e 1 para D_CPU_CONTADOR
+err_t cpu_leitura_contador(void *disp, int id, int *pvalor);
+err_t cpu_escrita_contador(void *disp, int id, int valor);
+
 // concatena a descrição do estado da CPU no final de str
 void cpu_concatena_descricao(cpu_t *self, char *str);
 
@@ -0,0 +1,54 @@
+// cronometro.c
+// medida do tempo gasto pelo simulador no computador hospedeiro
+// simulador de computador
+// so25b
+
+#include "cronometro.h"
+
+bool cronometro_ligado = false;
+uint64_t cronometro_tics_total[N_CRONO];
+uint64_t cronometro_n[N_CRONO];
+
+static char *nomes[N_CRONO] = {
+  [CRONO_CPU]       = "cpu_executa_1",
+  [CRONO_MMU]       = "mmu_le/mmu_escreve",
+  [CRONO_RELOGIO]   = "relogio_tictac",
+  [CRONO_SO]        = "so_trata_interrupcao",
+  [CRONO_TERMINAIS] = "console_tem_interrupcao",
+  [CRONO_CONSOLE]   = "console_tictac",
+  [CRONO_STATUS]    = "comandos/status",
+};
+
+void cronometro_liga(bool ligado)
+{
+  for (int i = 0; i < N_CRONO; i++) {
+    cronometro_tics_total[i] = 0;
+    cronometro_n[i] = 0;
+  }
+  cronometro_ligado = ligado;
+}
+
+char *cronometro_nome(cronometro_id_t id)
+{
+  if (id < 0 || id >= N_CRONO) return "?";
+  return nomes[id];
+}
+
+static double ns_agora(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+double cronometro_ns_por_tic(int ms)
+{
+  double ns_ini = ns_agora();
+  uint64_t tics_ini = cronometro_tics();
+  double ns_fim;
+  do {
+    ns_fim = ns_agora();
+  } while (ns_fim - ns_ini < ms * 1e6);
+  uint64_t tics = cronometro_tics() - tics_ini;
+  return (tics == 0) ? 1 : (ns_fim - ns_ini) / tics;
+}
@@ -0,0 +1,78 @@
+// cronometro.h
+// medida do tempo gasto pelo simulador no computador hospedeiro
+// simulador de computador
+// so25b
+
+#ifndef CRONOMETRO_H
+#define CRONOMETRO_H
+
+// acumula o tempo gasto (no computador hospedeiro) em algumas partes do
+//   simulador, para saber onde está o custo do laço de interpretação
+// as partes medidas são chamadas em cada instrução, então a medida tem que
+//   ser barata: usa o contador de ciclos do processador (rdtsc) quando
+//   existe, e só mede se cronometro_ligado for true (desligado, custa um
+//   teste por chamada)
+// as medidas são inclusivas: o tempo da CPU inclui o da MMU e o do SO, que
+//   são chamados durante a execução de uma instrução
+// uso, em uma função a medir:
+//     CRONOMETRO_INICIO(t);
+//     ... o que é medido ...
+//     CRONOMETRO_FIM(CRONO_MMU, t);
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef enum {
+  CRONO_CPU,       // cpu_executa_1
+  CRONO_MMU,       // mmu_le e mmu_escreve
+  CRONO_RELOGIO,   // relogio_tictac
+  CRONO_SO,        // so_trata_interrupcao
+  CRONO_TERMINAIS, // console_tem_interrupcao, nos dois pedidos de cada instrução
+  CRONO_CONSOLE,   // console_tictac
+  CRONO_STATUS,    // comandos da console e linha de status, em controle.c
+  N_CRONO
+} cronometro_id_t;
+
+extern bool cronometro_ligado;
+// tics acumulados e número de medidas de cada parte
+extern uint64_t cronometro_tics_total[N_CRONO];
+extern uint64_t cronometro_n[N_CRONO];
+
+// retorna o valor atual do contador de tics (ciclos do processador, ou
+//   nanossegundos se não tiver o contador de ciclos)
+static inline uint64_t cronometro_tics(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+#define CRONOMETRO_INICIO(var) \
+  uint64_t var = cronometro_ligado ? cronometro_tics() : 0
+#define CRONOMETRO_FIM(id, var) \
+  do { \
+    if (cronometro_ligado) { \
+      cronometro_tics_total[id] += cronometro_tics() - var; \
+      cronometro_n[id]++; \
+    } \
+  } while (0)
+
+// zera as medidas e liga ou desliga o cronômetro
+void cronometro_liga(bool ligado);
+
+// retorna o nome da parte medida
+char *cronometro_nome(cronometro_id_t id);
+
+// retorna a duração de um tic, em nanossegundos, medida comparando o
+//   contador de tics com o relógio do sistema durante 'ms' milissegundos
+double cronometro_ns_por_tic(int ms);
+
+#endif // CRONOMETRO_H
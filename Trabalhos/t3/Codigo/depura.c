@@ -0,0 +1,28 @@
+// depura.c
+// mensagens de depuração por subsistema e nível
+// simulador de computador
+// so25b
+
+#include "depura.h"
+
+#include <ctype.h>
+
+int depura_nivel[N_DEP] = {
+  [0 ... N_DEP - 1] = DEPURA_NIVEL_INICIAL
+};
+
+// letras que identificam os subsistemas, na ordem de depura_subsistema_t
+static char letras[N_DEP] = { 'i', 'p', 'm', 'c', 'e' };
+
+bool depura_define_nivel(char letra, int nivel)
+{
+  letra = tolower(letra);
+  bool achou = false;
+  for (int s = 0; s < N_DEP; s++) {
+    if (letra == '*' || letra == letras[s]) {
+      depura_nivel[s] = nivel;
+      achou = true;
+    }
+  }
+  return achou;
+}
@@ -0,0 +1,61 @@
+// depura.h
+// mensagens de depuração por subsistema e nível
+// simulador de computador
+// so25b
+
+#ifndef DEPURA_H
+#define DEPURA_H
+
+// as mensagens de depuração são impressas na console com a macro depura,
+//   que recebe o subsistema que gera a mensagem, o nível da mensagem e os
+//   argumentos de console_printf:
+//     depura(DEP_MEM, NIVEL_DETALHE, "quadro livre: %d", q);
+// a mensagem só é impressa se o nível dela não for maior que o nível
+//   definido para o subsistema, que pode ser alterado durante a execução
+//   (comando L da console)
+// mensagens com nível maior que DEPURA_NIVEL_MAX nem são compiladas; para
+//   não ter custo nenhum com elas, compile com -DDEPURA_NIVEL_MAX=n
+// os argumentos só são avaliados se a mensagem for impressa
+
+#include "console.h"
+#include <stdbool.h>
+
+// subsistemas
+typedef enum {
+  DEP_IRQ,      // interrupções  (letra 'i' no comando da console)
+  DEP_PROC,     // processos e escalonador  ('p')
+  DEP_MEM,      // memória  ('m')
+  DEP_CHAMADA,  // chamadas de sistema  ('c')
+  DEP_ES,       // entrada e saída  ('e')
+  N_DEP
+} depura_subsistema_t;
+
+// níveis, do mais para o menos importante
+#define NIVEL_ERRO    0
+#define NIVEL_AVISO   1
+#define NIVEL_INFO    2
+#define NIVEL_DETALHE 3
+
+// maior nível compilado
+#ifndef DEPURA_NIVEL_MAX
+#define DEPURA_NIVEL_MAX NIVEL_DETALHE
+#endif
+
+// nível inicial de todos os subsistemas
+#define DEPURA_NIVEL_INICIAL NIVEL_INFO
+
+// nível corrente de cada subsistema
+extern int depura_nivel[N_DEP];
+
+#define depura(subsistema, nivel, ...)                                      \
+  do {                                                                      \
+    if ((nivel) <= DEPURA_NIVEL_MAX && (nivel) <= depura_nivel[subsistema]) \
+      console_printf(__VA_ARGS__);                                          \
+  } while (0)
+
+// altera o nível do subsistema identificado pela letra 'letra' (ou de todos,
+//   se for '*')
+// retorna false se a letra não corresponder a nenhum subsistema
+bool depura_define_nivel(char letra, int nivel);
+
+#endif // DEPURA_H
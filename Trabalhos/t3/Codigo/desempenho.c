@@ -0,0 +1,272 @@
+// desempenho.c
+// mede o custo, no computador hospedeiro, de cada instrução simulada
+// simulador de computador
+// so25b
+
+// uso:
+//   ./desempenho [-n instruções] [-r repetições] [-h histórico] [nome=valor]...
+// executa o simulador (os mesmos componentes de main, sem a tela) com a
+//   carga padrão (init=carga.maq, ver gera_carga.c e o Makefile) durante um
+//   número fixo de instruções (-n, o padrão é 200000), e imprime quantos
+//   nanossegundos do computador hospedeiro custa cada instrução simulada
+// as opções nome=valor são as do simulador (ver config.h)
+// cada medida é feita em um processo filho, para que cada execução comece
+//   do mesmo estado; a execução sem cronômetro é repetida (-r, o padrão é 3)
+//   e o resultado é a menor medida, a menos perturbada pelo resto do
+//   computador
+// uma execução a mais, com o cronômetro ligado (ver cronometro.h), divide o
+//   custo entre cpu_executa_1, mmu_le/mmu_escreve, relogio_tictac,
+//   so_trata_interrupcao e a console (pedidos de interrupção dos terminais,
+//   console_tictac, e os comandos e a linha de status tratados pelo
+//   controle a cada instrução); como o cronômetro tem custo, a divisão é dada em
+//   porcentagem do tempo dessa execução
+// o progresso das execuções é mostrado em stderr na mesma linha, ou uma por
+//   linha se stderr não for um terminal (redirecionado para um arquivo)
+// o resultado é acrescentado ao arquivo de histórico (-h, o padrão é
+//   desempenho.hist), com a data e a revisão do git, em uma linha com pares
+//   nome=valor; a medida é comparada com a da última linha do histórico
+
+#include "hardware.h"
+#include "so.h"
+#include "metricas.h"
+#include "config.h"
+#include "cronometro.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#define TAM_LINHA 1000
+#define TAM_REVISAO 100
+
+// resultado de uma execução, passado do filho para o pai por um pipe
+typedef struct {
+  bool ok;
+  long instrucoes;
+  double ns;
+  uint64_t tics_total;
+  uint64_t tics[N_CRONO];
+  uint64_t n[N_CRONO];
+} medida_t;
+
+static config_t config;
+static int n_repeticoes = 3;
+static char *historico = "desempenho.hist";
+
+static void uso(char *nome)
+{
+  fprintf(stderr, "uso: %s [-n instruções] [-r repetições] [-h histórico] "
+                  "[nome=valor]...\nopções do simulador (com o valor padrão):\n",
+          nome);
+  config_imprime_opcoes(&config, stderr);
+  exit(1);
+}
+
+static double ns_agora(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// executa a simulação (no processo filho) e preenche 'm'
+static void executa(medida_t *m, bool com_cronometro)
+{
+  hardware_t hw;
+  cria_hardware(&hw, &config);
+  so_t *so = so_cria(hw.cpu, hw.mem, hw.mem2, hw.mmu, hw.es, hw.console, &config);
+  inicializa_metricas(&metricas);
+  console_insere_comando(hw.console, 'C');
+
+  cronometro_liga(com_cronometro);
+  uint64_t tics_ini = cronometro_tics();
+  double ns_ini = ns_agora();
+  controle_laco(hw.controle);
+  m->ns = ns_agora() - ns_ini;
+  m->tics_total = cronometro_tics() - tics_ini;
+  m->instrucoes = relogio_agora();
+  for (int i = 0; i < N_CRONO; i++) {
+    m->tics[i] = cronometro_tics_total[i];
+    m->n[i] = cronometro_n[i];
+  }
+  cronometro_liga(false);
+  m->ok = m->instrucoes > 0;
+
+  so_destroi(so);
+  destroi_hardware(&hw);
+}
+
+// executa a simulação em um processo filho e retorna a medida
+static medida_t mede(bool com_cronometro)
+{
+  medida_t m = { .ok = false };
+  int fd[2];
+  if (pipe(fd) != 0) {
+    perror("pipe");
+    exit(1);
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if (pid == 0) {
+    // filho: o que o simulador imprimir na saída padrão não interessa
+    close(fd[0]);
+    freopen("/dev/null", "w", stdout);
+    executa(&m, com_cronometro);
+    if (write(fd[1], &m, sizeof(m)) != sizeof(m)) _exit(1);
+    _exit(0);
+  }
+  close(fd[1]);
+  if (read(fd[0], &m, sizeof(m)) != sizeof(m)) m.ok = false;
+  close(fd[0]);
+  int estado;
+  waitpid(pid, &estado, 0);
+  if (!WIFEXITED(estado) || WEXITSTATUS(estado) != 0) m.ok = false;
+  return m;
+}
+
+// coloca em 'rev' a revisão do git (vazia se não tiver)
+static void revisao_git(char *rev, int tam)
+{
+  rev[0] = '\0';
+  FILE *p = popen("git describe --always --dirty 2>/dev/null", "r");
+  if (p == NULL) return;
+  if (fgets(rev, tam, p) == NULL) rev[0] = '\0';
+  pclose(p);
+  rev[strcspn(rev, "\n")] = '\0';
+}
+
+// retorna o valor de ns_instr da última linha do histórico (0 se não tiver)
+static double ultima_medida(char *rev_ant, int tam)
+{
+  double ns_instr = 0;
+  rev_ant[0] = '\0';
+  FILE *f = fopen(historico, "r");
+  if (f == NULL) return 0;
+  char linha[TAM_LINHA];
+  while (fgets(linha, sizeof(linha), f) != NULL) {
+    char *c = strstr(linha, "ns_instr=");
+    if (c != NULL) ns_instr = atof(c + strlen("ns_instr="));
+    c = strstr(linha, "revisao=");
+    if (c != NULL) snprintf(rev_ant, tam, "%.*s", (int)strcspn(c + 8, " \n"), c + 8);
+  }
+  fclose(f);
+  return ns_instr;
+}
+
+int main(int argc, char *argv[])
+{
+  int n_instrucoes = 200000;
+
+  config_inicializa(&config);
+  config.console = false;
+  snprintf(config.init, sizeof(config.init), "carga.maq");
+  snprintf(config.saida, sizeof(config.saida), "desempenho-");
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:r:h:")) != -1) {
+    switch (opt) {
+      case 'n': n_instrucoes = atoi(optarg); break;
+      case 'r': n_repeticoes = atoi(optarg); break;
+      case 'h': historico = optarg; break;
+      default: uso(argv[0]);
+    }
+  }
+  for (int i = optind; i < argc; i++) {
+    if (!config_le_opcao(&config, argv[i])) {
+      fprintf(stderr, "Opção inválida: '%s'\n", argv[i]);
+      uso(argv[0]);
+    }
+  }
+  if (n_instrucoes <= 0 || n_repeticoes <= 0) uso(argv[0]);
+  // a medida é sempre sem a tela, e termina no limite de instruções
+  config.console = false;
+  config.limite = n_instrucoes;
+
+  // medida sem cronômetro: a menor das repetições
+  medida_t melhor = { .ok = false };
+  double melhor_ns_instr = 0;
+  bool em_terminal = isatty(2);
+  for (int r = 0; r < n_repeticoes; r++) {
+    medida_t m = mede(false);
+    if (!m.ok) {
+      fprintf(stderr, "A simulação falhou (o programa '%s' existe?)\n", config.init);
+      exit(1);
+    }
+    double ns_instr = m.ns / m.instrucoes;
+    fprintf(stderr, "%sexecução %d/%d: %.2f ns/instrução%s", em_terminal ? "\r" : "",
+            r + 1, n_repeticoes, ns_instr, em_terminal ? "" : "\n");
+    if (!melhor.ok || ns_instr < melhor_ns_instr) {
+      melhor = m;
+      melhor_ns_instr = ns_instr;
+    }
+  }
+  if (em_terminal) fprintf(stderr, "\n");
+
+  // medida com cronômetro, para a divisão do custo
+  medida_t cron = mede(true);
+  if (!cron.ok) {
+    fprintf(stderr, "A simulação com cronômetro falhou\n");
+    exit(1);
+  }
+  double ns_por_tic = cronometro_ns_por_tic(100);
+  // as medidas são inclusivas (ver cronometro.h): separa a parte de cada um
+  double pct[N_CRONO], pct_resto;
+  double total = cron.tics_total;
+  pct[CRONO_MMU] = 100 * cron.tics[CRONO_MMU] / total;
+  pct[CRONO_SO] = 100 * cron.tics[CRONO_SO] / total;
+  pct[CRONO_CPU] = 100 * cron.tics[CRONO_CPU] / total - pct[CRONO_MMU] - pct[CRONO_SO];
+  pct[CRONO_RELOGIO] = 100 * cron.tics[CRONO_RELOGIO] / total;
+  pct[CRONO_TERMINAIS] = 100 * cron.tics[CRONO_TERMINAIS] / total;
+  pct[CRONO_CONSOLE] = 100 * cron.tics[CRONO_CONSOLE] / total;
+  pct[CRONO_STATUS] = 100 * cron.tics[CRONO_STATUS] / total;
+  pct_resto = 100 - 100 * (cron.tics[CRONO_CPU] + cron.tics[CRONO_RELOGIO]
+                           + cron.tics[CRONO_TERMINAIS] + cron.tics[CRONO_CONSOLE]
+                           + cron.tics[CRONO_STATUS]) / total;
+
+  char rev[TAM_REVISAO], rev_ant[TAM_REVISAO];
+  revisao_git(rev, sizeof(rev));
+  double ns_instr_ant = ultima_medida(rev_ant, sizeof(rev_ant));
+
+  printf("instruções simuladas: %ld (%d execuções)\n", melhor.instrucoes, n_repeticoes);
+  printf("tempo: %.3f s, %.2f ns/instrução, %.2f Minstr/s\n", melhor.ns / 1e9,
+         melhor_ns_instr, 1e3 / melhor_ns_instr);
+  printf("com cronômetro: %.2f ns/instrução (%.1f ns/tic)\n",
+         cron.ns / cron.instrucoes, ns_por_tic);
+  printf("%-24s %7s %12s %10s\n", "parte", "%", "chamadas", "ns/chamada");
+  for (int i = 0; i < N_CRONO; i++) {
+    double ns_chamada = cron.n[i] == 0 ? 0 : cron.tics[i] * ns_por_tic / cron.n[i];
+    printf("%-24s %6.1f%% %12llu %10.1f\n", cronometro_nome(i), pct[i],
+           (unsigned long long)cron.n[i], ns_chamada);
+  }
+  printf("%-24s %6.1f%%\n", "resto do laço", pct_resto);
+  printf("(cpu_executa_1 sem o tempo de mmu_le/mmu_escreve e so_trata_interrupcao)\n");
+  if (ns_instr_ant > 0) {
+    printf("anterior (%s): %.2f ns/instrução, variação %+.1f%%\n", rev_ant,
+           ns_instr_ant, 100 * (melhor_ns_instr - ns_instr_ant) / ns_instr_ant);
+  }
+
+  FILE *f = fopen(historico, "a");
+  if (f == NULL) {
+    perror(historico);
+    exit(1);
+  }
+  char data[30];
+  time_t agora = time(NULL);
+  strftime(data, sizeof(data), "%Y-%m-%dT%H:%M:%S", localtime(&agora));
+  fprintf(f, "data=%s revisao=%s instrucoes=%ld ns_instr=%.3f", data,
+          rev[0] == '\0' ? "-" : rev, melhor.instrucoes, melhor_ns_instr);
+  fprintf(f, " cpu=%.1f mmu=%.1f relogio=%.1f so=%.1f terminais=%.1f console=%.1f"
+             " status=%.1f resto=%.1f\n",
+          pct[CRONO_CPU], pct[CRONO_MMU], pct[CRONO_RELOGIO], pct[CRONO_SO],
+          pct[CRONO_TERMINAIS], pct[CRONO_CONSOLE], pct[CRONO_STATUS], pct_resto);
+  fclose(f);
+  return 0;
+}
@@ -33,6 +33,8 @@ typedef enum {
   D_RELOGIO_REAL,
   D_RELOGIO_TIMER,
   D_RELOGIO_INTERRUPCAO,
+  D_CPU_CONTADOR_SEL,     // número do contador a ler (ver cpu.h)
+  D_CPU_CONTADOR,         // valor do contador escolhido
   N_DISPOSITIVOS
 } dispositivo_id_t;
 
@@ -18,6 +18,8 @@ typedef struct {
    void *controladora;
    // identificador do dispositivo (argumento para as funções acima)
    int id;
+   // pode ser acessado em modo usuário
+   bool usuario;
 } dispositivo_t;
 
 // define a estrutura opaca
@@ -46,9 +48,23 @@ bool es_registra_dispositivo(es_t *self, dispositivo_id_t dispositivo,
   self->dispositivos[dispositivo].id = id;
   self->dispositivos[dispositivo].f_leitura = f_leitura;
   self->dispositivos[dispositivo].f_escrita = f_escrita;
+  self->dispositivos[dispositivo].usuario = false;
   return true;
 }
 
+bool es_libera_usuario(es_t *self, dispositivo_id_t dispositivo)
+{
+  if (dispositivo < 0 || dispositivo >= N_DISPOSITIVOS) return false;
+  self->dispositivos[dispositivo].usuario = true;
+  return true;
+}
+
+bool es_acesso_usuario(es_t *self, dispositivo_id_t dispositivo)
+{
+  if (dispositivo < 0 || dispositivo >= N_DISPOSITIVOS) return false;
+  return self->dispositivos[dispositivo].usuario;
+}
+
 err_t es_le(es_t *self, dispositivo_id_t dispositivo, int *pvalor)
 {
   if (dispositivo < 0 || dispositivo >= N_DISPOSITIVOS) return ERR_DISP_INV;
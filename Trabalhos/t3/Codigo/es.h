@@ -44,6 +44,14 @@ bool es_registra_dispositivo(es_t *self, dispositivo_id_t dispositivo,
                              void *controladora, int id,
                              f_leitura_t f_leitura, f_escrita_t f_escrita);
 
+// libera o acesso ao dispositivo em modo usuário (as instruções LE e ESCR
+//   são privilegiadas para os outros dispositivos)
+// retorna false se o dispositivo não existe
+bool es_libera_usuario(es_t *self, dispositivo_id_t dispositivo);
+
+// retorna true se o dispositivo pode ser acessado em modo usuário
+bool es_acesso_usuario(es_t *self, dispositivo_id_t dispositivo);
+
 // lê um inteiro de um dispositivo
 // retorna ERR_OK se bem sucedido, ou
 //   ERR_DISP_INV se dispositivo desconhecido
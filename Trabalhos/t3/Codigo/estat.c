@@ -0,0 +1,314 @@
+// estat.c
+// estatísticas com nome: contadores, medidores e histogramas
+// simulador de computador
+// so25b
+
+#include "estat.h"
+#include "indice.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+
+// tamanho máximo de um nome
+#define TAM_NOME 100
+// faixas dos histogramas, log-lineares (como no HdrHistogram): os valores
+//   menores que 2^PRECISAO têm uma faixa cada; cada potência de 2 acima
+//   disso é dividida em 2^PRECISAO faixas iguais, então o erro relativo de
+//   um valor representado pela faixa é no máximo 2^-PRECISAO
+#define PRECISAO 4
+#define SUBFAIXAS (1 << PRECISAO)
+#define N_FAIXAS ((64 - PRECISAO) * SUBFAIXAS)
+
+typedef enum { CONTADOR, MEDIDOR, HISTOGRAMA } tipo_t;
+
+static char *nome_tipo[] = { "contadores", "medidores", "histogramas" };
+
+struct estat_t {
+  char nome[TAM_NOME];
+  tipo_t tipo;
+  long valor;           // contador ou medidor
+  // histograma
+  long n, soma, min, max;
+  long faixas[N_FAIXAS];
+};
+
+// todas as estatísticas, na ordem de criação
+static estat_t **estats = NULL;
+static int n_estats = 0;
+static int cap_estats = 0;
+
+// índice dos nomes, com posições em estats
+static indice_t *indice = NULL;
+
+// série temporal: cada amostra tem os valores das 'n' primeiras
+//   estatísticas (as que existiam na data da amostra), a partir de
+//   valores[ini] (o valor dos histogramas é ignorado)
+typedef struct {
+  long data;
+  int n;
+  int ini;
+} amostra_t;
+static amostra_t *amostras = NULL;
+static int n_amostras = 0;
+static int cap_amostras = 0;
+static long *valores = NULL;
+static int n_valores = 0;
+static int cap_valores = 0;
+
+// retorna a estatística 'nome', criando com o tipo 'tipo' se não existir
+static estat_t *estat_pega(tipo_t tipo, char *fmt, va_list ap)
+{
+  char nome[TAM_NOME];
+  vsnprintf(nome, sizeof(nome), fmt, ap);
+
+  if (indice == NULL) indice = indice_cria();
+  int pos = indice_busca(indice, nome);
+  if (pos != -1) {
+    assert(estats[pos]->tipo == tipo);
+    return estats[pos];
+  }
+
+  estat_t *e = calloc(1, sizeof(*e));
+  assert(e != NULL);
+  strcpy(e->nome, nome);
+  e->tipo = tipo;
+  estats = vetor_cresce(estats, &cap_estats, n_estats + 1, sizeof(estat_t *));
+  indice_insere(indice, e->nome, n_estats);
+  estats[n_estats++] = e;
+  return e;
+}
+
+estat_t *estat_contador(char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  estat_t *e = estat_pega(CONTADOR, fmt, ap);
+  va_end(ap);
+  return e;
+}
+
+estat_t *estat_medidor(char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  estat_t *e = estat_pega(MEDIDOR, fmt, ap);
+  va_end(ap);
+  return e;
+}
+
+estat_t *estat_histograma(char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  estat_t *e = estat_pega(HISTOGRAMA, fmt, ap);
+  va_end(ap);
+  return e;
+}
+
+void estat_soma(estat_t *self, long n)
+{
+  self->valor += n;
+}
+
+void estat_define(estat_t *self, long valor)
+{
+  self->valor = valor;
+}
+
+// faixa do histograma onde fica o valor (valores negativos contam como 0)
+static int faixa(long valor)
+{
+  if (valor < SUBFAIXAS) return (valor < 0) ? 0 : valor;
+  // expoente: quantos bits além da precisão o valor tem
+  int e = 63 - __builtin_clzl(valor) - PRECISAO;
+  return (e + 1) * SUBFAIXAS + (valor >> e) - SUBFAIXAS;
+}
+
+// menor e maior valor da faixa 'k'
+static long faixa_min(int k)
+{
+  if (k < SUBFAIXAS) return k;
+  int e = k / SUBFAIXAS - 1;
+  return (long)(k % SUBFAIXAS + SUBFAIXAS) << e;
+}
+
+static long faixa_max(int k)
+{
+  if (k < SUBFAIXAS) return k;
+  int e = k / SUBFAIXAS - 1;
+  return ((long)(k % SUBFAIXAS + SUBFAIXAS + 1) << e) - 1;
+}
+
+void estat_registra(estat_t *self, long valor)
+{
+  if (self->n == 0 || valor < self->min) self->min = valor;
+  if (self->n == 0 || valor > self->max) self->max = valor;
+  self->n++;
+  self->soma += valor;
+  self->faixas[faixa(valor)]++;
+}
+
+long estat_valor(estat_t *self)
+{
+  return (self->tipo == HISTOGRAMA) ? self->n : self->valor;
+}
+
+double estat_media(estat_t *self)
+{
+  return (self->n == 0) ? 0 : (double)self->soma / self->n;
+}
+
+long estat_percentil(estat_t *self, double p)
+{
+  if (self->n == 0) return 0;
+  // posição (a partir de 1) do valor procurado, na ordem crescente
+  long pos = (long)(p / 100 * self->n + 0.999999);
+  if (pos < 1) pos = 1;
+  long acumulado = 0;
+  for (int k = 0; k < N_FAIXAS; k++) {
+    acumulado += self->faixas[k];
+    if (acumulado >= pos) {
+      long v = faixa_max(k);
+      return (v > self->max) ? self->max : v;
+    }
+  }
+  return self->max;
+}
+
+void estat_imprime_histogramas(FILE *f)
+{
+  for (int e = 0; e < n_estats; e++) {
+    estat_t *h = estats[e];
+    if (h->tipo != HISTOGRAMA) continue;
+    fprintf(f, "- %s: n[%ld] p50[%ld] p90[%ld] p99[%ld] max[%ld]\n", h->nome, h->n,
+            estat_percentil(h, 50), estat_percentil(h, 90), estat_percentil(h, 99), h->max);
+  }
+}
+
+void estat_amostra(long agora)
+{
+  amostras = vetor_cresce(amostras, &cap_amostras, n_amostras + 1, sizeof(amostra_t));
+  valores = vetor_cresce(valores, &cap_valores, n_valores + n_estats, sizeof(long));
+  amostras[n_amostras].data = agora;
+  amostras[n_amostras].n = n_estats;
+  amostras[n_amostras].ini = n_valores;
+  for (int e = 0; e < n_estats; e++) {
+    valores[n_valores++] = estats[e]->valor;
+  }
+  n_amostras++;
+}
+
+// escreve uma string JSON (os nomes não têm caracteres especiais, mas...)
+static void escreve_str_json(FILE *f, char *s)
+{
+  fputc('"', f);
+  for (; *s != '\0'; s++) {
+    if (*s == '"' || *s == '\\') fputc('\\', f);
+    fputc(*s, f);
+  }
+  fputc('"', f);
+}
+
+static bool amostravel(estat_t *e)
+{
+  return e->tipo != HISTOGRAMA;
+}
+
+bool estat_exporta_json(char *nome)
+{
+  FILE *f = fopen(nome, "w");
+  if (f == NULL) return false;
+
+  fprintf(f, "{\n");
+  // contadores e medidores
+  for (tipo_t tipo = CONTADOR; tipo <= MEDIDOR; tipo++) {
+    fprintf(f, "  \"%s\": {", nome_tipo[tipo]);
+    bool primeiro = true;
+    for (int e = 0; e < n_estats; e++) {
+      if (estats[e]->tipo != tipo) continue;
+      fprintf(f, "%s\n    ", primeiro ? "" : ",");
+      escreve_str_json(f, estats[e]->nome);
+      fprintf(f, ": %ld", estats[e]->valor);
+      primeiro = false;
+    }
+    fprintf(f, "\n  },\n");
+  }
+  // histogramas
+  fprintf(f, "  \"%s\": {", nome_tipo[HISTOGRAMA]);
+  bool primeiro = true;
+  for (int e = 0; e < n_estats; e++) {
+    estat_t *h = estats[e];
+    if (h->tipo != HISTOGRAMA) continue;
+    fprintf(f, "%s\n    ", primeiro ? "" : ",");
+    escreve_str_json(f, h->nome);
+    fprintf(f, ": {\"n\": %ld, \"soma\": %ld, \"min\": %ld, \"max\": %ld, "
+               "\"p50\": %ld, \"p90\": %ld, \"p99\": %ld, \"faixas\": [",
+            h->n, h->soma, h->min, h->max,
+            estat_percentil(h, 50), estat_percentil(h, 90), estat_percentil(h, 99));
+    // só as faixas não vazias
+    bool primeira = true;
+    for (int k = 0; k < N_FAIXAS; k++) {
+      if (h->faixas[k] == 0) continue;
+      fprintf(f, "%s{\"de\": %ld, \"ate\": %ld, \"n\": %ld}", primeira ? "" : ", ",
+              faixa_min(k), faixa_max(k), h->faixas[k]);
+      primeira = false;
+    }
+    fprintf(f, "]}");
+    primeiro = false;
+  }
+  fprintf(f, "\n  },\n");
+  // série temporal
+  fprintf(f, "  \"serie\": {\n    \"nomes\": [");
+  primeiro = true;
+  for (int e = 0; e < n_estats; e++) {
+    if (!amostravel(estats[e])) continue;
+    fprintf(f, "%s", primeiro ? "" : ", ");
+    escreve_str_json(f, estats[e]->nome);
+    primeiro = false;
+  }
+  fprintf(f, "],\n    \"amostras\": [");
+  for (int a = 0; a < n_amostras; a++) {
+    fprintf(f, "%s\n      [%ld", a == 0 ? "" : ",", amostras[a].data);
+    for (int e = 0; e < n_estats; e++) {
+      if (!amostravel(estats[e])) continue;
+      if (e < amostras[a].n) {
+        fprintf(f, ", %ld", valores[amostras[a].ini + e]);
+      } else {
+        fprintf(f, ", null");
+      }
+    }
+    fprintf(f, "]");
+  }
+  fprintf(f, "\n    ]\n  }\n}\n");
+
+  return fclose(f) == 0;
+}
+
+bool estat_exporta_csv(char *nome)
+{
+  FILE *f = fopen(nome, "w");
+  if (f == NULL) return false;
+
+  fprintf(f, "tempo");
+  for (int e = 0; e < n_estats; e++) {
+    if (amostravel(estats[e])) fprintf(f, ",%s", estats[e]->nome);
+  }
+  fprintf(f, "\n");
+  for (int a = 0; a < n_amostras; a++) {
+    fprintf(f, "%ld", amostras[a].data);
+    for (int e = 0; e < n_estats; e++) {
+      if (!amostravel(estats[e])) continue;
+      if (e < amostras[a].n) {
+        fprintf(f, ",%ld", valores[amostras[a].ini + e]);
+      } else {
+        fprintf(f, ",");
+      }
+    }
+    fprintf(f, "\n");
+  }
+
+  return fclose(f) == 0;
+}
@@ -0,0 +1,72 @@
+// estat.h
+// estatísticas com nome: contadores, medidores e histogramas
+// simulador de computador
+// so25b
+
+#ifndef ESTAT_H
+#define ESTAT_H
+
+// cada estatística tem um nome, formado como em printf, por exemplo
+//     estat_soma(estat_contador("proc.%d.faltas_pagina", n), 1);
+// a estatística é criada no primeiro uso do nome
+// tipos:
+//   contador   -- valor que só aumenta (estat_soma)
+//   medidor    -- valor que pode subir e descer (estat_define)
+//   histograma -- distribuição de valores registrados (estat_registra),
+//                 com o número, a soma, o mínimo, o máximo e a contagem por
+//                 faixas log-lineares (16 faixas por potência de 2), de
+//                 onde saem os percentis com erro de no máximo 1/16
+// os valores de todos os contadores e medidores podem ser amostrados
+//   (estat_amostra), formando uma série temporal
+// tudo pode ser exportado em JSON (estatísticas e série) e em CSV (série)
+
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct estat_t estat_t;
+
+// retornam a estatística com o nome formado por 'fmt', criando se for
+//   necessário
+// um nome já usado com outro tipo é um erro
+estat_t *estat_contador(char *fmt, ...);
+estat_t *estat_medidor(char *fmt, ...);
+estat_t *estat_histograma(char *fmt, ...);
+
+// soma 'n' a um contador
+void estat_soma(estat_t *self, long n);
+
+// altera o valor de um medidor
+void estat_define(estat_t *self, long valor);
+
+// registra um valor em um histograma
+void estat_registra(estat_t *self, long valor);
+
+// retorna o valor de um contador ou medidor, ou o número de valores
+//   registrados em um histograma
+long estat_valor(estat_t *self);
+
+// retorna a média dos valores registrados em um histograma (0 se vazio)
+double estat_media(estat_t *self);
+
+// retorna o valor abaixo do qual estão 'p' por cento dos valores
+//   registrados no histograma (o limite superior da faixa desse valor)
+long estat_percentil(estat_t *self, double p);
+
+// imprime em 'f' uma linha com o número, os percentis 50, 90 e 99 e o
+//   máximo de cada histograma
+void estat_imprime_histogramas(FILE *f);
+
+// acrescenta à série temporal uma amostra, na data 'agora', com o valor
+//   de todos os contadores e medidores
+void estat_amostra(long agora);
+
+// escreve todas as estatísticas e a série temporal no arquivo 'nome', em JSON
+// retorna false se não conseguir escrever o arquivo
+bool estat_exporta_json(char *nome);
+
+// escreve a série temporal no arquivo 'nome', em CSV, uma amostra por linha
+//   e uma coluna por estatística (vazia se a estatística ainda não existia)
+// retorna false se não conseguir escrever o arquivo
+bool estat_exporta_csv(char *nome);
+
+#endif // ESTAT_H
@@ -0,0 +1,268 @@
+// experimentos.c
+// executa o simulador com várias configurações e junta os resultados
+// simulador de computador
+// so25b
+
+// uso:
+//   ./experimentos [-j n] [-d dir] [-l limite] [-s simulador] nome=v1,v2,... ...
+// cada argumento nome=v1,v2,... é uma opção do simulador (ver config.h) com
+//   a lista dos valores a experimentar; o simulador é executado (sem console)
+//   uma vez para cada combinação de valores, por exemplo
+//     ./experimentos mem=1000,500,250 swap=0,50
+//   executa 6 simulações
+// as simulações são executadas em paralelo, no máximo n de cada vez (-j, o
+//   padrão é o número de processadores)
+// os arquivos de cada simulação ficam no diretório dir (-d, o padrão é
+//   "resultados"), com o número da simulação como prefixo; a linha de
+//   resumo que o simulador imprime fica em NNN-resumo
+// cada simulação termina quando os processos terminam ou quando o relógio
+//   do simulador chegar ao limite (-l), para não ficar presa em uma
+//   configuração em que algum processo nunca termina
+// o relatório tem uma linha por simulação, com os valores das opções e os
+//   valores do resumo; é impresso na saída padrão e em dir/experimentos.csv
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <assert.h>
+
+#define MAX_PARAMETROS 20
+#define MAX_VALORES 100
+#define MAX_CAMPOS 30
+#define TAM_LINHA 1000
+#define TAM_NOME 300
+
+// uma opção do simulador, com os valores a experimentar
+typedef struct {
+  char *nome;
+  char *valores[MAX_VALORES];
+  int n_valores;
+} parametro_t;
+
+// resultado de uma simulação: pares nome=valor do resumo
+typedef struct {
+  pid_t pid;
+  bool ok;
+  char linha[TAM_LINHA];
+  char *nomes[MAX_CAMPOS];
+  char *valores[MAX_CAMPOS];
+  int n_campos;
+} resultado_t;
+
+static parametro_t parametros[MAX_PARAMETROS];
+static int n_parametros = 0;
+static char *diretorio = "resultados";
+static char *simulador = "./main";
+static int limite = 10000000;
+static int n_paralelos = 0;
+
+static void uso(char *nome)
+{
+  fprintf(stderr, "uso: %s [-j n] [-d dir] [-l limite] [-s simulador] "
+                  "nome=v1,v2,... ...\n", nome);
+  fprintf(stderr, "  as opções do simulador são listadas por '%s -h'\n", simulador);
+  exit(1);
+}
+
+// separa "nome=v1,v2,..." em um parâmetro (altera 'arg')
+static void le_parametro(char *arg, char *nome_prog)
+{
+  char *igual = strchr(arg, '=');
+  if (igual == NULL || igual == arg || n_parametros >= MAX_PARAMETROS) uso(nome_prog);
+  parametro_t *p = &parametros[n_parametros++];
+  *igual = '\0';
+  p->nome = arg;
+  p->n_valores = 0;
+  for (char *v = strtok(igual + 1, ","); v != NULL; v = strtok(NULL, ",")) {
+    if (p->n_valores >= MAX_VALORES) uso(nome_prog);
+    p->valores[p->n_valores++] = v;
+  }
+  if (p->n_valores == 0) uso(nome_prog);
+}
+
+// índice do valor de cada parâmetro na simulação 'n' (o último parâmetro
+//   varia mais rápido)
+static int indice_valor(int n, int par)
+{
+  for (int p = n_parametros - 1; p > par; p--) {
+    n /= parametros[p].n_valores;
+  }
+  return n % parametros[par].n_valores;
+}
+
+// dispara a simulação 'n', com a saída padrão em dir/NNN-resumo
+static pid_t dispara(int n)
+{
+  char prefixo[TAM_NOME], resumo[TAM_NOME + 10];
+  snprintf(prefixo, sizeof(prefixo), "%s/%03d-", diretorio, n);
+  snprintf(resumo, sizeof(resumo), "%sresumo", prefixo);
+
+  pid_t pid = fork();
+  if (pid != 0) return pid;
+
+  // filho: monta os argumentos e executa o simulador
+  char *args[MAX_PARAMETROS + 5];
+  char opcoes[MAX_PARAMETROS + 3][TAM_NOME + 20];
+  int n_args = 0;
+  args[n_args++] = simulador;
+  snprintf(opcoes[0], sizeof(opcoes[0]), "console=0");
+  snprintf(opcoes[1], sizeof(opcoes[1]), "saida=%s", prefixo);
+  snprintf(opcoes[2], sizeof(opcoes[2]), "limite=%d", limite);
+  for (int o = 0; o < 3; o++) args[n_args++] = opcoes[o];
+  for (int p = 0; p < n_parametros; p++) {
+    snprintf(opcoes[p + 3], sizeof(opcoes[p + 3]), "%s=%s", parametros[p].nome,
+             parametros[p].valores[indice_valor(n, p)]);
+    args[n_args++] = opcoes[p + 3];
+  }
+  args[n_args] = NULL;
+
+  int fd = open(resumo, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  int nulo = open("/dev/null", O_RDONLY);
+  if (fd < 0 || nulo < 0) {
+    perror(resumo);
+    _exit(1);
+  }
+  dup2(fd, 1);
+  dup2(nulo, 0);
+  close(fd);
+  close(nulo);
+  execv(simulador, args);
+  perror(simulador);
+  _exit(1);
+}
+
+// lê o resumo da simulação 'n' e separa os pares nome=valor
+static void le_resultado(int n, resultado_t *r)
+{
+  char nome[TAM_NOME + 10];
+  snprintf(nome, sizeof(nome), "%s/%03d-resumo", diretorio, n);
+  r->n_campos = 0;
+  FILE *f = fopen(nome, "r");
+  if (f == NULL || fgets(r->linha, sizeof(r->linha), f) == NULL) {
+    r->ok = false;
+  }
+  if (f != NULL) fclose(f);
+  if (!r->ok) return;
+  for (char *c = strtok(r->linha, " \n"); c != NULL; c = strtok(NULL, " \n")) {
+    char *igual = strchr(c, '=');
+    if (igual == NULL || r->n_campos >= MAX_CAMPOS) continue;
+    *igual = '\0';
+    r->nomes[r->n_campos] = c;
+    r->valores[r->n_campos] = igual + 1;
+    r->n_campos++;
+  }
+}
+
+// imprime o relatório em 'f', com os campos separados por 'sep'
+static void imprime_relatorio(FILE *f, char *sep, resultado_t *res, int n_sim)
+{
+  // os nomes dos campos vêm do primeiro resultado que deu certo
+  resultado_t *modelo = NULL;
+  for (int n = 0; n < n_sim && modelo == NULL; n++) {
+    if (res[n].ok) modelo = &res[n];
+  }
+
+  fprintf(f, "sim");
+  for (int p = 0; p < n_parametros; p++) fprintf(f, "%s%s", sep, parametros[p].nome);
+  if (modelo != NULL) {
+    for (int c = 0; c < modelo->n_campos; c++) fprintf(f, "%s%s", sep, modelo->nomes[c]);
+  }
+  fprintf(f, "\n");
+
+  for (int n = 0; n < n_sim; n++) {
+    fprintf(f, "%d", n);
+    for (int p = 0; p < n_parametros; p++) {
+      fprintf(f, "%s%s", sep, parametros[p].valores[indice_valor(n, p)]);
+    }
+    if (!res[n].ok) {
+      fprintf(f, "%sfalhou", sep);
+    } else if (modelo != NULL) {
+      for (int c = 0; c < modelo->n_campos; c++) {
+        // procura pelo nome, caso os resumos não tenham os mesmos campos
+        char *valor = "";
+        for (int d = 0; d < res[n].n_campos; d++) {
+          if (strcmp(res[n].nomes[d], modelo->nomes[c]) == 0) valor = res[n].valores[d];
+        }
+        fprintf(f, "%s%s", sep, valor);
+      }
+    }
+    fprintf(f, "\n");
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "j:d:l:s:")) != -1) {
+    switch (opt) {
+      case 'j': n_paralelos = atoi(optarg); break;
+      case 'd': diretorio = optarg; break;
+      case 'l': limite = atoi(optarg); break;
+      case 's': simulador = optarg; break;
+      default: uso(argv[0]);
+    }
+  }
+  for (int i = optind; i < argc; i++) le_parametro(argv[i], argv[0]);
+  if (n_paralelos <= 0) n_paralelos = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n_paralelos <= 0) n_paralelos = 1;
+
+  int n_sim = 1;
+  for (int p = 0; p < n_parametros; p++) n_sim *= parametros[p].n_valores;
+
+  if (mkdir(diretorio, 0755) != 0 && errno != EEXIST) {
+    perror(diretorio);
+    exit(1);
+  }
+
+  resultado_t *res = calloc(n_sim, sizeof(*res));
+  assert(res != NULL);
+
+  // dispara as simulações, no máximo n_paralelos de cada vez
+  int proxima = 0, executando = 0, terminadas = 0;
+  while (terminadas < n_sim) {
+    while (executando < n_paralelos && proxima < n_sim) {
+      res[proxima].pid = dispara(proxima);
+      if (res[proxima].pid < 0) {
+        perror("fork");
+        exit(1);
+      }
+      proxima++;
+      executando++;
+    }
+    int estado;
+    pid_t pid = wait(&estado);
+    if (pid < 0) {
+      perror("wait");
+      exit(1);
+    }
+    for (int n = 0; n < proxima; n++) {
+      if (res[n].pid != pid) continue;
+      res[n].ok = WIFEXITED(estado) && WEXITSTATUS(estado) == 0;
+      le_resultado(n, &res[n]);
+      fprintf(stderr, "\r%d/%d", terminadas + 1, n_sim);
+    }
+    executando--;
+    terminadas++;
+  }
+  fprintf(stderr, "\n");
+
+  imprime_relatorio(stdout, "\t", res, n_sim);
+  char nome[TAM_NOME + 20];
+  snprintf(nome, sizeof(nome), "%s/experimentos.csv", diretorio);
+  FILE *f = fopen(nome, "w");
+  if (f == NULL) {
+    perror(nome);
+  } else {
+    imprime_relatorio(f, ",", res, n_sim);
+    fclose(f);
+  }
+
+  free(res);
+  return 0;
+}
@@ -69,6 +69,22 @@ int fila_deque(Fila *self) {
 }
 
 
+bool fila_remove(Fila *self, int dado) {
+    NoFila **pp = &self->pri;
+    while (*pp != NULL) {
+        if ((*pp)->dado == dado) {
+            NoFila *no_removido = *pp;
+            *pp = no_removido->prox;
+            free(no_removido);
+            self->n_elem--;
+            return true;
+        }
+        pp = &(*pp)->prox;
+    }
+    return false;
+}
+
+
 int fila_get(Fila *self, int pos) {
     if (fila_vazia(self)) return -1;
 
@@ -24,6 +24,9 @@ void fila_enque(Fila *self, int dado);
 
 int fila_deque(Fila *self);
 
+// remove a primeira ocorrência de dado na fila, retorna false se não achar
+bool fila_remove(Fila *self, int dado);
+
 int fila_get(Fila *self, int pos);
 
 int fila_n_elem(Fila *self);
@@ -0,0 +1,580 @@
+// gera_carga.c
+// gerador de programas de carga para o simulador
+// simulador de computador
+// so25b
+
+// gera na saída padrão um programa em linguagem de montagem, de um dos
+//   tipos abaixo, com os parâmetros dados na forma nome=valor
+// uso:
+//   ./gera_carga tipo [nome=valor]... > prog.asm
+// tipos e parâmetros (com o valor padrão):
+//   cpu         laço só de contas, sem acesso a vetor
+//               n=10000 iterações
+//   sequencial  percorre um vetor de 'tam' palavras com passo 'passo',
+//               'voltas' vezes, lendo e (se escrita=1) alterando
+//               tam=500 passo=1 voltas=10 escrita=1
+//   aleatorio   acessa posições pseudo-aleatórias de um vetor de 'tam'
+//               palavras (gerador congruente linear, com 'semente')
+//               tam=500 acessos=5000 semente=1 escrita=1
+//   fases       conjunto de trabalho que muda: o vetor tem 'fases' partes
+//               de 'tam' palavras, e cada parte é percorrida 'voltas'
+//               vezes antes de passar para a próxima
+//               tam=200 fases=4 voltas=10 escrita=1
+//   es          rajadas de escrita no terminal: 'rajadas' vezes escreve
+//               'tam' caracteres e faz 'pausa' iterações de contas
+//               rajadas=10 tam=20 pausa=500
+//   fora        acessa o endereço 'end', que deve estar fora da memória do
+//               processo (o SO deve matar o processo, e só ele)
+//               end=30000
+//   dorme       'vezes' vezes faz 'contas' iterações de contas e dorme
+//               'tempo' instruções (SO_DORME)
+//               vezes=10 contas=100 tempo=500
+//   linha       'vezes' vezes lê uma linha do terminal (SO_LE_LINHA) para
+//               um vetor de 'tam' caracteres, e escreve o que leu entre
+//               colchetes (a entrada vem do operador ou do roteiro da
+//               console, ver console.h)
+//               vezes=4 tam=4
+//   lancador    cria processos, como init.asm: os programas da lista
+//               'progs' (separados por vírgula) são criados em grupos de
+//               'grupo' processos, e cada grupo é esperado antes do próximo;
+//               a lista é executada 'rodadas' vezes
+//               com 'dorme' positivo, o lançador dorme esse tempo depois de
+//               criar cada grupo; com 'mata' 1, os processos do grupo são
+//               mortos (SO_MATA_PROC) em vez de esperados -- eles devem
+//               estar vivos, ou o pid pode já ser de outro processo
+//               progs=p1.maq grupo=4 rodadas=1 dorme=0 mata=0
+// todos os programas terminam com uma mensagem e se matam (o tipo fora só
+//   chega ao fim se o SO não o matar)
+// os programas gerados são montados no endereço 0 (ver Makefile)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define MAX_PARAMETROS 20
+#define MAX_PROGS 50
+
+// parâmetros da linha de comando
+typedef struct {
+  char *nome;
+  char *valor;
+  bool usado;
+} parametro_t;
+
+static parametro_t parametros[MAX_PARAMETROS];
+static int n_parametros = 0;
+static char *tipo;
+
+static void uso(char *nome)
+{
+  fprintf(stderr, "uso: %s tipo [nome=valor]...\n", nome);
+  fprintf(stderr, "  tipos: cpu sequencial aleatorio fases es fora dorme lancador "
+                  "(ver gera_carga.c)\n");
+  exit(1);
+}
+
+// retorna o texto do parâmetro 'nome', ou 'padrao' se não foi dado
+static char *par_txt(char *nome, char *padrao)
+{
+  for (int i = 0; i < n_parametros; i++) {
+    if (strcmp(parametros[i].nome, nome) == 0) {
+      parametros[i].usado = true;
+      return parametros[i].valor;
+    }
+  }
+  return padrao;
+}
+
+// retorna o valor do parâmetro inteiro 'nome', que deve ser pelo menos 'min'
+static int par(char *nome, int padrao, int min)
+{
+  char *txt = par_txt(nome, NULL);
+  if (txt == NULL) return padrao;
+  char *fim;
+  long valor = strtol(txt, &fim, 10);
+  if (*txt == '\0' || *fim != '\0' || valor < min || valor != (int)valor) {
+    fprintf(stderr, "parâmetro '%s' inválido: '%s' (mínimo %d)\n", nome, txt, min);
+    exit(1);
+  }
+  return valor;
+}
+
+// GERAÇÃO {{{1
+
+// início de todos os programas
+static void gera_cabecalho(char *descricao)
+{
+  printf("; programa de carga gerado por gera_carga\n");
+  printf("; %s\n", descricao);
+  printf(";");
+  printf(" %s", tipo);
+  for (int i = 0; i < n_parametros; i++) {
+    printf(" %s=%s", parametros[i].nome, parametros[i].valor);
+  }
+  printf("\n\n");
+  printf("; chamadas de sistema (ver so.h)\n");
+  printf("SO_ESCR        define 2\n");
+  printf("SO_CRIA_PROC   define 7\n");
+  printf("SO_MATA_PROC   define 8\n");
+  printf("SO_ESPERA_PROC define 9\n");
+  printf("SO_DORME       define 10\n");
+  printf("SO_ESCR_STR    define 11\n");
+  printf("SO_LE_LINHA    define 12\n\n");
+  printf("         desv main\n");
+  printf("msg_fim  string '%s fim '\n", tipo);
+  printf("um       valor 1\n\n");
+  printf("main\n");
+}
+
+// fim de todos os programas: imprime a mensagem e se mata, e o que for usado
+//   pelo programa (variáveis e o vetor, se 'tam_vetor' for positivo)
+static void gera_final(int tam_vetor)
+{
+  printf("\n         ; acabou -- imprime a mensagem e morre\n");
+  printf("         cargi msg_fim\n");
+  printf("         trax\n");
+  printf("         cargi SO_ESCR_STR\n");
+  printf("         chamas\n");
+  printf("morre    cargi 0\n");
+  printf("         trax\n");
+  printf("         cargi SO_MATA_PROC\n");
+  printf("         chamas\n");
+  printf("         desv morre\n\n");
+  printf("; variáveis\n");
+  printf("i        espaco 1\n");
+  printf("pos      espaco 1\n");
+  printf("volta    espaco 1\n");
+  if (tam_vetor > 0) {
+    printf("\n; o vetor fica no fim, depois de todo o código\n");
+    printf("vet      espaco %d\n", tam_vetor);
+  }
+}
+
+// lê vet[X], soma 1 e, se 'escrita', grava de volta
+static void gera_acesso(bool escrita)
+{
+  printf("         cargx vet\n");
+  if (escrita) {
+    printf("         soma um\n");
+    printf("         armx vet\n");
+  }
+}
+
+static void gera_cpu(void)
+{
+  int n = par("n", 10000, 1);
+  gera_cabecalho("laço só de contas");
+  printf("         ; acc = (acc * 7 + i) %% 10007, n vezes\n");
+  printf("         cargi 0\n");
+  printf("         armm i\n");
+  printf("laco     cargm acc\n");
+  printf("         mult sete\n");
+  printf("         soma i\n");
+  printf("         resto primo\n");
+  printf("         armm acc\n");
+  printf("         cargm i\n");
+  printf("         soma um\n");
+  printf("         armm i\n");
+  printf("         sub ene\n");
+  printf("         desvnz laco\n");
+  printf("         desv fim\n");
+  printf("acc      valor 1\n");
+  printf("sete     valor 7\n");
+  printf("primo    valor 10007\n");
+  printf("ene      valor %d\n", n);
+  printf("fim\n");
+  gera_final(0);
+}
+
+static void gera_sequencial(void)
+{
+  int tam = par("tam", 500, 1);
+  int passo = par("passo", 1, 1);
+  int voltas = par("voltas", 10, 1);
+  bool escrita = par("escrita", 1, 0);
+  gera_cabecalho("percorre um vetor com passo fixo");
+  printf("         cargi 0\n");
+  printf("         armm volta\n");
+  printf("nvolta   cargi 0\n");
+  printf("         armm pos\n");
+  printf("laco     cargm pos\n");
+  printf("         trax\n");
+  gera_acesso(escrita);
+  printf("         cargm pos\n");
+  printf("         soma passo\n");
+  printf("         armm pos\n");
+  printf("         sub tam\n");
+  printf("         desvn laco\n");
+  printf("         cargm volta\n");
+  printf("         soma um\n");
+  printf("         armm volta\n");
+  printf("         sub voltas\n");
+  printf("         desvnz nvolta\n");
+  printf("         desv fim\n");
+  printf("tam      valor %d\n", tam);
+  printf("passo    valor %d\n", passo);
+  printf("voltas   valor %d\n", voltas);
+  printf("fim\n");
+  gera_final(tam);
+}
+
+static void gera_aleatorio(void)
+{
+  int tam = par("tam", 500, 1);
+  int acessos = par("acessos", 5000, 1);
+  int semente = par("semente", 1, 0);
+  bool escrita = par("escrita", 1, 0);
+  gera_cabecalho("acessa posições pseudo-aleatórias de um vetor");
+  printf("         ; x = (x * 75 + 74) %% 65537; acessa vet[x %% tam]\n");
+  printf("         cargm acessos\n");
+  printf("         armm i\n");
+  printf("laco     cargm x\n");
+  printf("         mult a_lcg\n");
+  printf("         soma c_lcg\n");
+  printf("         resto m_lcg\n");
+  printf("         armm x\n");
+  printf("         resto tam\n");
+  printf("         trax\n");
+  gera_acesso(escrita);
+  printf("         cargm i\n");
+  printf("         sub um\n");
+  printf("         armm i\n");
+  printf("         desvnz laco\n");
+  printf("         desv fim\n");
+  printf("x        valor %d\n", semente % 65537);
+  printf("a_lcg    valor 75\n");
+  printf("c_lcg    valor 74\n");
+  printf("m_lcg    valor 65537\n");
+  printf("tam      valor %d\n", tam);
+  printf("acessos  valor %d\n", acessos);
+  printf("fim\n");
+  gera_final(tam);
+}
+
+static void gera_fases(void)
+{
+  int tam = par("tam", 200, 1);
+  int fases = par("fases", 4, 1);
+  int voltas = par("voltas", 10, 1);
+  bool escrita = par("escrita", 1, 0);
+  gera_cabecalho("conjunto de trabalho que muda a cada fase");
+  printf("         cargi 0\n");
+  printf("         armm base\n");
+  printf("nfase    cargi 0\n");
+  printf("         armm volta\n");
+  printf("nvolta   cargi 0\n");
+  printf("         armm pos\n");
+  printf("laco     cargm base\n");
+  printf("         soma pos\n");
+  printf("         trax\n");
+  gera_acesso(escrita);
+  printf("         cargm pos\n");
+  printf("         soma um\n");
+  printf("         armm pos\n");
+  printf("         sub tam\n");
+  printf("         desvn laco\n");
+  printf("         cargm volta\n");
+  printf("         soma um\n");
+  printf("         armm volta\n");
+  printf("         sub voltas\n");
+  printf("         desvnz nvolta\n");
+  printf("         cargm base\n");
+  printf("         soma tam\n");
+  printf("         armm base\n");
+  printf("         sub total\n");
+  printf("         desvn nfase\n");
+  printf("         desv fim\n");
+  printf("base     espaco 1\n");
+  printf("tam      valor %d\n", tam);
+  printf("voltas   valor %d\n", voltas);
+  printf("total    valor %d\n", tam * fases);
+  printf("fim\n");
+  gera_final(tam * fases);
+}
+
+static void gera_es(void)
+{
+  int rajadas = par("rajadas", 10, 1);
+  int tam = par("tam", 20, 1);
+  int pausa = par("pausa", 500, 1);
+  gera_cabecalho("rajadas de escrita no terminal");
+  printf("         cargi 0\n");
+  printf("         armm volta\n");
+  printf("rajada   cargi 0\n");
+  printf("         armm pos\n");
+  printf("         ; escreve 'tam' caracteres, de 'a' em diante\n");
+  printf("escreve  cargm pos\n");
+  printf("         resto vinte6\n");
+  printf("         soma letra_a\n");
+  printf("         trax\n");
+  printf("         cargi SO_ESCR\n");
+  printf("         chamas\n");
+  printf("         cargm pos\n");
+  printf("         soma um\n");
+  printf("         armm pos\n");
+  printf("         sub tam\n");
+  printf("         desvnz escreve\n");
+  printf("         ; pausa, fazendo contas\n");
+  printf("         cargm pausa\n");
+  printf("         armm i\n");
+  printf("espera   cargm i\n");
+  printf("         sub um\n");
+  printf("         armm i\n");
+  printf("         desvnz espera\n");
+  printf("         cargm volta\n");
+  printf("         soma um\n");
+  printf("         armm volta\n");
+  printf("         sub rajadas\n");
+  printf("         desvnz rajada\n");
+  printf("         desv fim\n");
+  printf("tam      valor %d\n", tam);
+  printf("pausa    valor %d\n", pausa);
+  printf("rajadas  valor %d\n", rajadas);
+  printf("vinte6   valor 26\n");
+  printf("letra_a  valor 'a'\n");
+  printf("fim\n");
+  gera_final(0);
+}
+
+static void gera_fora(void)
+{
+  int end = par("end", 30000, -1000000);
+  gera_cabecalho("acessa um endereço fora da memória do processo");
+  printf("         cargm %d\n", end);
+  printf("         desv fim\n");
+  printf("fim\n");
+  gera_final(0);
+}
+
+static void gera_dorme(void)
+{
+  int vezes = par("vezes", 10, 1);
+  int contas = par("contas", 100, 1);
+  int tempo = par("tempo", 500, 0);
+  gera_cabecalho("alterna contas e sono");
+  printf("         cargi 0\n");
+  printf("         armm volta\n");
+  printf("rodada   cargm contas\n");
+  printf("         armm i\n");
+  printf("conta    cargm i\n");
+  printf("         sub um\n");
+  printf("         armm i\n");
+  printf("         desvnz conta\n");
+  printf("         cargm tempo\n");
+  printf("         trax\n");
+  printf("         cargi SO_DORME\n");
+  printf("         chamas\n");
+  printf("         cargm volta\n");
+  printf("         soma um\n");
+  printf("         armm volta\n");
+  printf("         sub vezes\n");
+  printf("         desvnz rodada\n");
+  printf("         desv fim\n");
+  printf("vezes    valor %d\n", vezes);
+  printf("contas   valor %d\n", contas);
+  printf("tempo    valor %d\n", tempo);
+  printf("fim\n");
+  gera_final(0);
+}
+
+static void gera_linha(void)
+{
+  int vezes = par("vezes", 4, 1);
+  int tam = par("tam", 4, 1);
+  gera_cabecalho("lê linhas do terminal e escreve o que leu");
+  printf("         cargi 0\n");
+  printf("         armm volta\n");
+  printf("         ; vet[0] é o tamanho do vetor, a linha vem depois\n");
+  printf("le       cargm tam\n");
+  printf("         armm vet\n");
+  printf("         cargi vet\n");
+  printf("         trax\n");
+  printf("         cargi SO_LE_LINHA\n");
+  printf("         chamas\n");
+  printf("         cargm abre\n");
+  printf("         trax\n");
+  printf("         cargi SO_ESCR\n");
+  printf("         chamas\n");
+  printf("         cargi vet\n");
+  printf("         soma um\n");
+  printf("         trax\n");
+  printf("         cargi SO_ESCR_STR\n");
+  printf("         chamas\n");
+  printf("         cargm fecha\n");
+  printf("         trax\n");
+  printf("         cargi SO_ESCR\n");
+  printf("         chamas\n");
+  printf("         cargm volta\n");
+  printf("         soma um\n");
+  printf("         armm volta\n");
+  printf("         sub vezes\n");
+  printf("         desvnz le\n");
+  printf("         desv fim\n");
+  printf("vezes    valor %d\n", vezes);
+  printf("tam      valor %d\n", tam);
+  printf("abre     valor '['\n");
+  printf("fecha    valor ']'\n");
+  printf("fim\n");
+  // o tamanho, a linha e o 0 no final
+  gera_final(tam + 2);
+}
+
+static void gera_lancador(void)
+{
+  char *lista = strdup(par_txt("progs", "p1.maq"));
+  int grupo = par("grupo", 4, 1);
+  int rodadas = par("rodadas", 1, 1);
+  int dorme = par("dorme", 0, 0);
+  bool mata = par("mata", 0, 0);
+  char *progs[MAX_PROGS];
+  int n_progs = 0;
+  for (char *p = strtok(lista, ","); p != NULL; p = strtok(NULL, ",")) {
+    if (n_progs >= MAX_PROGS) {
+      fprintf(stderr, "muitos programas (máximo %d)\n", MAX_PROGS);
+      exit(1);
+    }
+    progs[n_progs++] = p;
+  }
+  if (n_progs == 0) {
+    fprintf(stderr, "a lista de programas está vazia\n");
+    exit(1);
+  }
+
+  gera_cabecalho("cria processos em grupos e espera cada grupo terminar");
+  printf("         cargi 0\n");
+  printf("         armm volta\n");
+  printf("rodada   cargi 0\n");
+  printf("         armm i\n");
+  printf("ngrupo   cargi 0\n");
+  printf("         armm pos\n");
+  printf("         ; cria o processo para progs[i], guarda o pid em pids[pos]\n");
+  printf("cria     cargm i\n");
+  printf("         sub n_progs\n");
+  printf("         desvz espera\n");
+  printf("         cargm i\n");
+  printf("         trax\n");
+  printf("         cargx progs\n");
+  printf("         trax\n");
+  printf("         cargi SO_CRIA_PROC\n");
+  printf("         chamas\n");
+  printf("         armm pid\n");
+  printf("         cargm pos\n");
+  printf("         trax\n");
+  printf("         cargm pid\n");
+  printf("         armx pids\n");
+  printf("         cargm i\n");
+  printf("         soma um\n");
+  printf("         armm i\n");
+  printf("         cargm pos\n");
+  printf("         soma um\n");
+  printf("         armm pos\n");
+  printf("         sub grupo\n");
+  printf("         desvnz cria\n");
+  // rótulo do laço que espera (ou mata) os processos do grupo
+  char *laco = "espera";
+  if (dorme > 0) {
+    printf("         ; dorme antes de %s os processos do grupo\n",
+           mata ? "matar" : "esperar");
+    printf("espera   cargm t_dorme\n");
+    printf("         trax\n");
+    printf("         cargi SO_DORME\n");
+    printf("         chamas\n");
+    laco = "laco_g";
+  }
+  if (mata) {
+    printf("         ; mata os processos do grupo (quem não foi criado tem pid\n");
+    printf("         ;   negativo, e é pulado)\n");
+  } else {
+    printf("         ; espera os processos do grupo (quem não foi criado tem\n");
+    printf("         ;   pid negativo, e a espera retorna sem bloquear)\n");
+  }
+  printf("%-8s cargm pos\n", laco);
+  printf("         desvz proximo\n");
+  printf("         sub um\n");
+  printf("         armm pos\n");
+  printf("         trax\n");
+  printf("         cargx pids\n");
+  if (mata) printf("         desvn %s\n", laco);
+  printf("         trax\n");
+  printf("         cargi %s\n", mata ? "SO_MATA_PROC" : "SO_ESPERA_PROC");
+  printf("         chamas\n");
+  printf("         desv %s\n", laco);
+  printf("proximo  cargm i\n");
+  printf("         sub n_progs\n");
+  printf("         desvnz ngrupo\n");
+  printf("         cargm volta\n");
+  printf("         soma um\n");
+  printf("         armm volta\n");
+  printf("         sub rodadas\n");
+  printf("         desvnz rodada\n");
+  printf("         desv fim\n");
+  printf("pid      espaco 1\n");
+  printf("pids     espaco %d\n", grupo);
+  printf("n_progs  valor %d\n", n_progs);
+  printf("grupo    valor %d\n", grupo);
+  printf("rodadas  valor %d\n", rodadas);
+  if (dorme > 0) printf("t_dorme  valor %d\n", dorme);
+  printf("; endereço do nome de cada programa\n");
+  printf("progs    valor nome0\n");
+  for (int p = 1; p < n_progs; p++) {
+    printf("         valor nome%d\n", p);
+  }
+  for (int p = 0; p < n_progs; p++) {
+    printf("nome%-4d string '%s'\n", p, progs[p]);
+  }
+  printf("fim\n");
+  gera_final(0);
+  free(lista);
+}
+
+// PRINCIPAL {{{1
+
+static struct {
+  char *tipo;
+  void (*gera)(void);
+} tipos[] = {
+  { "cpu",        gera_cpu        },
+  { "sequencial", gera_sequencial },
+  { "aleatorio",  gera_aleatorio  },
+  { "fases",      gera_fases      },
+  { "es",         gera_es         },
+  { "fora",       gera_fora       },
+  { "dorme",      gera_dorme      },
+  { "linha",      gera_linha      },
+  { "lancador",   gera_lancador   },
+};
+#define N_TIPOS (int)(sizeof(tipos) / sizeof(tipos[0]))
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2) uso(argv[0]);
+  tipo = argv[1];
+  for (int i = 2; i < argc; i++) {
+    char *igual = strchr(argv[i], '=');
+    if (igual == NULL || igual == argv[i] || n_parametros >= MAX_PARAMETROS) uso(argv[0]);
+    *igual = '\0';
+    parametros[n_parametros].nome = argv[i];
+    parametros[n_parametros].valor = igual + 1;
+    parametros[n_parametros].usado = false;
+    n_parametros++;
+  }
+
+  for (int t = 0; t < N_TIPOS; t++) {
+    if (strcmp(tipos[t].tipo, tipo) != 0) continue;
+    tipos[t].gera();
+    // um parâmetro que não foi usado provavelmente está com o nome errado
+    int erros = 0;
+    for (int i = 0; i < n_parametros; i++) {
+      if (parametros[i].usado) continue;
+      fprintf(stderr, "parâmetro '%s' não existe para o tipo '%s'\n",
+              parametros[i].nome, tipo);
+      erros++;
+    }
+    return erros == 0 ? 0 : 1;
+  }
+  fprintf(stderr, "tipo '%s' desconhecido\n", tipo);
+  uso(argv[0]);
+}
+
+// vim: foldmethod=marker
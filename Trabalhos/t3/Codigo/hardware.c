@@ -0,0 +1,120 @@
+// hardware.c
+// criação e destruição dos componentes do computador simulado
+// simulador de computador
+// so25b
+
+#include "hardware.h"
+#include "programa.h"
+#include "terminal.h"
+#include "dispositivos.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+// registra no controlador de es os 4 dispositivos do terminal 'id_term'
+//   da console, com valores a partir de n_disp
+static void registra_terminal(hardware_t *hw, int n_disp, char id_term)
+{
+  terminal_t *terminal;
+  terminal = console_terminal(hw->console, id_term);
+  // por exemplo, depois de registrado, quando o controlador de ES receber um
+  //   pedido de leitura do dispositivo 'n_disp+TERM_TECLADO' (que é 4 para
+  //   o terminal 'B'), vai chamar a função 'terminal_leitura', passando como
+  //   argumentos o valor de 'terminal' (que é o terminal 'B' obtido acima) e
+  //   o valor TERM_TECLADO
+  es_registra_dispositivo(hw->es, n_disp + TERM_TECLADO,    terminal, TERM_TECLADO,    terminal_leitura, NULL);
+  // a escrita nos dispositivos de estado reconhece o pedido de interrupção
+  es_registra_dispositivo(hw->es, n_disp + TERM_TECLADO_OK, terminal, TERM_TECLADO_OK, terminal_leitura, terminal_escrita);
+  es_registra_dispositivo(hw->es, n_disp + TERM_TELA,       terminal, TERM_TELA,       NULL, terminal_escrita);
+  es_registra_dispositivo(hw->es, n_disp + TERM_TELA_OK,    terminal, TERM_TELA_OK,    terminal_leitura, terminal_escrita);
+}
+
+// inicializa a memória ROM com o conteúdo do programa em bios.maq
+static void inicializa_rom(mem_t *mem)
+{
+  // programa para executar na nossa CPU
+  programa_t *prog = prog_cria("bios.maq");
+  if (prog == NULL) {
+    fprintf(stderr, "Erro na leitura da ROM ('bios.maq')\n");
+    exit(1);
+  }
+
+  int end_ini = prog_end_carga(prog);
+  if (end_ini != CPU_END_RESET) {
+    fprintf(stderr, "ROM não inicia no endereço %d (%d)\n", CPU_END_RESET, end_ini);
+    exit(1);
+  }
+  int end_fim = end_ini + prog_tamanho(prog);
+  if (end_fim > CPU_END_FIM_ROM) {
+    fprintf(stderr, "conteúdo da ROM muito grande (%d>%d)\n", end_fim, CPU_END_FIM_ROM);
+    exit(1);
+  }
+
+  for (int end = end_ini; end < end_fim; end++) {
+    if (mem_escreve(mem, end, prog_dado(prog, end)) != ERR_OK) {
+      printf("Erro na carga da memória ROM, endereco %d\n", end);
+      exit(1);
+    }
+  }
+  prog_destroi(prog);
+}
+
+void cria_hardware(hardware_t *hw, config_t *config)
+{
+  // cria a memória
+  hw->mem = mem_cria(config->mem_tam);
+  inicializa_rom(hw->mem);
+  // cria a MMU
+  hw->mmu = mmu_cria(hw->mem, config->tam_pagina);
+ // cria a memória secundária
+  hw->mem2 = mem_cria(config->mem2_tam);
+
+  // cria dispositivos de E/S
+  char nome_log[TAM_TEXTO_CONFIG + 20];
+  config_nome_arquivo(config, "log_da_console", nome_log, sizeof(nome_log));
+  hw->console = console_cria(config->console, nome_log, config->historico);
+  if (config->roteiro[0] != '\0' && !console_le_roteiro(hw->console, config->roteiro)) {
+    exit(1);
+  }
+  hw->relogio = relogio_cria();
+
+  // cria o controlador de E/S e registra os dispositivos
+  //   por exemplo, o dispositivo 8 do controlador de E/S (e da CPU) será o
+  //   dispositivo 0 do relógio (que é o contador de instruções)
+  hw->es = es_cria();
+  // registra os 4 dispositivos de cada terminal
+  registra_terminal(hw, D_TERM_A, 'A');
+  registra_terminal(hw, D_TERM_B, 'B');
+  registra_terminal(hw, D_TERM_C, 'C');
+  registra_terminal(hw, D_TERM_D, 'D');
+  // registra os 4 dispositivos do relógio
+  es_registra_dispositivo(hw->es, D_RELOGIO_INSTRUCOES, hw->relogio, 0, relogio_leitura, NULL);
+  es_registra_dispositivo(hw->es, D_RELOGIO_REAL      , hw->relogio, 1, relogio_leitura, NULL);
+  es_registra_dispositivo(hw->es, D_RELOGIO_TIMER     , hw->relogio, 2, relogio_leitura, relogio_escrita);
+  es_registra_dispositivo(hw->es, D_RELOGIO_INTERRUPCAO,hw->relogio, 3, relogio_leitura, relogio_escrita);
+
+  // cria a unidade de execução e inicializa com a MMU e o controlador de E/S
+  hw->cpu = cpu_cria(hw->mmu, hw->es);
+  // registra os contadores de desempenho da CPU, que os programas podem ler
+  //   em modo usuário (ver cpu.h)
+  es_registra_dispositivo(hw->es, D_CPU_CONTADOR_SEL, hw->cpu, 0, cpu_leitura_contador, cpu_escrita_contador);
+  es_registra_dispositivo(hw->es, D_CPU_CONTADOR,     hw->cpu, 1, cpu_leitura_contador, NULL);
+  es_libera_usuario(hw->es, D_CPU_CONTADOR_SEL);
+  es_libera_usuario(hw->es, D_CPU_CONTADOR);
+
+  // cria o controlador da CPU e inicializa com a unidade de execução, a console e
+  //   o relógio
+  hw->controle = controle_cria(hw->cpu, hw->console, hw->relogio);
+}
+
+void destroi_hardware(hardware_t *hw)
+{
+  controle_destroi(hw->controle);
+  cpu_destroi(hw->cpu);
+  es_destroi(hw->es);
+  relogio_destroi(hw->relogio);
+  console_destroi(hw->console);
+  mmu_destroi(hw->mmu);
+  mem_destroi(hw->mem);
+  mem_destroi(hw->mem2);
+}
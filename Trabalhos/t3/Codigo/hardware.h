@@ -0,0 +1,41 @@
+// hardware.h
+// criação e destruição dos componentes do computador simulado
+// simulador de computador
+// so25b
+
+#ifndef HARDWARE_H
+#define HARDWARE_H
+
+// usado por main e pelos programas que executam o simulador sem a tela
+//   (ver desempenho.c)
+
+#include "memoria.h"
+#include "mmu.h"
+#include "cpu.h"
+#include "relogio.h"
+#include "console.h"
+#include "es.h"
+#include "controle.h"
+#include "config.h"
+
+// estrutura com os componentes do computador simulado
+typedef struct {
+  mem_t *mem;
+  mem_t *mem2;
+  mmu_t *mmu;
+  cpu_t *cpu;
+  relogio_t *relogio;
+  console_t *console;
+  es_t *es;
+  controle_t *controle;
+} hardware_t;
+
+// cria e interliga todos os componentes, conforme a configuração
+// inicializa a ROM com o conteúdo de bios.maq (termina o programa se não
+//   conseguir)
+void cria_hardware(hardware_t *hw, config_t *config);
+
+// destrói todos os componentes
+void destroi_hardware(hardware_t *hw);
+
+#endif // HARDWARE_H
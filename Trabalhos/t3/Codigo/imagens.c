@@ -0,0 +1,161 @@
+// imagens.c
+// cache de imagens de programas executáveis
+// simulador de computador
+// so25b
+
+#include "imagens.h"
+#include "metricas.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+typedef struct {
+  char *nome;
+  // identificação da versão do arquivo de onde a imagem foi lida
+  struct timespec mtime;
+  off_t tam_arquivo;
+  ino_t inode;
+  programa_t *prog;
+  int n_palavras;  // memória ocupada pela imagem
+  int n_usos;      // número de imagens_pega ainda não devolvidos
+  long ultimo_uso; // valor de 'relogio' no último imagens_pega
+  // o arquivo mudou: a imagem não é mais entregue, e é destruída quando
+  //   não estiver mais em uso
+  bool obsoleta;
+} imagem_t;
+
+struct imagens_t {
+  imagem_t *imagens;
+  int n_imagens;
+  int capacidade;
+  int orcamento;
+  int n_palavras;  // memória ocupada por todas as imagens
+  long relogio;    // contador de pedidos, para saber qual imagem é a mais antiga
+};
+
+imagens_t *imagens_cria(int orcamento)
+{
+  imagens_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->capacidade = 8;
+  self->imagens = malloc(self->capacidade * sizeof(imagem_t));
+  assert(self->imagens != NULL);
+  self->n_imagens = 0;
+  self->orcamento = orcamento;
+  self->n_palavras = 0;
+  self->relogio = 0;
+  return self;
+}
+
+// tira a imagem da posição 'i' do cache e destrói o programa
+static void imagens_remove(imagens_t *self, int i)
+{
+  imagem_t *img = &self->imagens[i];
+  self->n_palavras -= img->n_palavras;
+  prog_destroi(img->prog);
+  free(img->nome);
+  self->imagens[i] = self->imagens[--self->n_imagens];
+}
+
+void imagens_destroi(imagens_t *self)
+{
+  while (self->n_imagens > 0) {
+    imagens_remove(self, self->n_imagens - 1);
+  }
+  free(self->imagens);
+  free(self);
+}
+
+// descarta imagens sem uso, da mais antiga para a mais nova, até caber
+//   no orçamento
+static void imagens_respeita_orcamento(imagens_t *self)
+{
+  while (self->n_palavras > self->orcamento) {
+    int mais_antiga = -1;
+    for (int i = 0; i < self->n_imagens; i++) {
+      imagem_t *img = &self->imagens[i];
+      if (img->n_usos > 0) continue;
+      if (mais_antiga < 0 || img->ultimo_uso < self->imagens[mais_antiga].ultimo_uso) {
+        mais_antiga = i;
+      }
+    }
+    if (mais_antiga < 0) return;  // todas estão em uso
+    imagens_remove(self, mais_antiga);
+  }
+}
+
+static bool mesma_versao(imagem_t *img, struct stat *st)
+{
+  return img->mtime.tv_sec == st->st_mtim.tv_sec
+      && img->mtime.tv_nsec == st->st_mtim.tv_nsec
+      && img->tam_arquivo == st->st_size
+      && img->inode == st->st_ino;
+}
+
+programa_t *imagens_pega(imagens_t *self, char *nome)
+{
+  struct stat st;
+  if (stat(nome, &st) != 0) return NULL;
+  self->relogio++;
+
+  for (int i = 0; i < self->n_imagens; i++) {
+    imagem_t *img = &self->imagens[i];
+    if (img->obsoleta || strcmp(img->nome, nome) != 0) continue;
+    if (mesma_versao(img, &st)) {
+      metricas.n_imagens_acertos++;
+      img->n_usos++;
+      img->ultimo_uso = self->relogio;
+      return img->prog;
+    }
+    // o arquivo mudou
+    if (img->n_usos == 0) {
+      imagens_remove(self, i);
+    } else {
+      img->obsoleta = true;
+    }
+    break;
+  }
+
+  metricas.n_imagens_faltas++;
+  programa_t *prog = prog_cria(nome);
+  if (prog == NULL) return NULL;
+
+  if (self->n_imagens >= self->capacidade) {
+    self->capacidade *= 2;
+    self->imagens = realloc(self->imagens, self->capacidade * sizeof(imagem_t));
+    assert(self->imagens != NULL);
+  }
+  imagem_t *img = &self->imagens[self->n_imagens++];
+  img->nome = strdup(nome);
+  assert(img->nome != NULL);
+  img->mtime = st.st_mtim;
+  img->tam_arquivo = st.st_size;
+  img->inode = st.st_ino;
+  img->prog = prog;
+  img->n_palavras = prog_tamanho(prog);
+  img->n_usos = 1;
+  img->ultimo_uso = self->relogio;
+  img->obsoleta = false;
+  self->n_palavras += img->n_palavras;
+
+  imagens_respeita_orcamento(self);
+  return prog;
+}
+
+void imagens_devolve(imagens_t *self, programa_t *prog)
+{
+  for (int i = 0; i < self->n_imagens; i++) {
+    imagem_t *img = &self->imagens[i];
+    if (img->prog != prog) continue;
+    img->n_usos--;
+    if (img->obsoleta && img->n_usos == 0) {
+      imagens_remove(self, i);
+    } else {
+      imagens_respeita_orcamento(self);
+    }
+    return;
+  }
+}
@@ -0,0 +1,44 @@
+// imagens.h
+// cache de imagens de programas executáveis
+// simulador de computador
+// so25b
+
+#ifndef IMAGENS_H
+#define IMAGENS_H
+
+// mantém os programas (programa_t) já lidos pelo SO, para que a criação de
+//   outro processo com o mesmo executável não precise ler o arquivo de novo
+//
+// cada imagem é identificada pelo nome do arquivo; a cada pedido, o SO
+//   consulta (com stat) a data de alteração, o tamanho e o i-node do
+//   arquivo, e só usa a imagem guardada se forem os mesmos de quando ela
+//   foi lida
+// as imagens ocupam no máximo um orçamento de memória (em palavras); quando
+//   o orçamento é ultrapassado, são descartadas as imagens que estão há mais
+//   tempo sem uso (LRU), desde que não estejam sendo usadas
+// uma imagem é usada entre imagens_pega e imagens_devolve; uma imagem em
+//   uso nunca é descartada, mesmo se o orçamento for ultrapassado
+//
+// os acertos e faltas são contados em metricas
+
+#include "programa.h"
+
+typedef struct imagens_t imagens_t;
+
+// cria um cache vazio, que ocupa no máximo 'orcamento' palavras
+imagens_t *imagens_cria(int orcamento);
+
+// destrói o cache e todas as imagens que estão nele
+// nenhuma imagem pode estar em uso
+void imagens_destroi(imagens_t *self);
+
+// retorna o programa do arquivo 'nome', do cache se for possível, senão
+//   lendo o arquivo (e colocando no cache)
+// o programa deve ser devolvido com imagens_devolve, e não destruído
+// retorna NULL se não for possível ler o programa
+programa_t *imagens_pega(imagens_t *self, char *nome);
+
+// devolve um programa obtido com imagens_pega
+void imagens_devolve(imagens_t *self, programa_t *prog);
+
+#endif // IMAGENS_H
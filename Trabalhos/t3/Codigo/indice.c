@@ -0,0 +1,110 @@
+// indice.c
+// índice de nomes (tabela hash) e vetores que crescem
+// simulador de computador
+// so25b
+
+#include "indice.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// uma posição da tabela; valor -1 se vazia
+typedef struct {
+  char *nome;
+  unsigned hash;
+  int valor;
+} entrada_t;
+
+struct indice_t {
+  entrada_t *tab;
+  int tam;            // potência de 2
+  int n;              // número de nomes na tabela
+};
+
+indice_t *indice_cria(void)
+{
+  indice_t *self = calloc(1, sizeof(*self));
+  assert(self != NULL);
+  return self;
+}
+
+void indice_destroi(indice_t *self)
+{
+  free(self->tab);
+  free(self);
+}
+
+unsigned indice_hash(char *s)
+{
+  unsigned h = 2166136261u;
+  while (*s != '\0') {
+    h ^= (unsigned char)*s++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// retorna a posição de 'nome' na tabela, ou a posição vazia onde ele
+//   deve ser inserido
+static int indice_posicao(indice_t *self, char *nome, unsigned h)
+{
+  int i = h & (self->tam - 1);
+  while (self->tab[i].valor != -1) {
+    entrada_t *e = &self->tab[i];
+    if (e->hash == h && strcmp(e->nome, nome) == 0) break;
+    i = (i + 1) & (self->tam - 1);
+  }
+  return i;
+}
+
+// refaz a tabela com o dobro do tamanho
+static void indice_rehash(indice_t *self)
+{
+  entrada_t *velha = self->tab;
+  int tam_velha = self->tam;
+  self->tam = (self->tam == 0) ? 256 : 2 * self->tam;
+  self->tab = malloc(self->tam * sizeof(entrada_t));
+  assert(self->tab != NULL);
+  for (int i = 0; i < self->tam; i++) self->tab[i].valor = -1;
+  for (int v = 0; v < tam_velha; v++) {
+    if (velha[v].valor == -1) continue;
+    self->tab[indice_posicao(self, velha[v].nome, velha[v].hash)] = velha[v];
+  }
+  free(velha);
+}
+
+int indice_busca(indice_t *self, char *nome)
+{
+  if (self->n == 0) return -1;
+  return self->tab[indice_posicao(self, nome, indice_hash(nome))].valor;
+}
+
+void indice_insere(indice_t *self, char *nome, int valor)
+{
+  assert(valor >= 0);
+  // mantém a tabela no máximo meio cheia
+  if (2 * (self->n + 1) > self->tam) indice_rehash(self);
+  unsigned h = indice_hash(nome);
+  int i = indice_posicao(self, nome, h);
+  assert(self->tab[i].valor == -1);
+  self->tab[i] = (entrada_t){ .nome = nome, .hash = h, .valor = valor };
+  self->n++;
+}
+
+void indice_limpa(indice_t *self)
+{
+  for (int i = 0; i < self->tam; i++) self->tab[i].valor = -1;
+  self->n = 0;
+}
+
+void *vetor_cresce(void *v, int *pcap, int n, size_t tam)
+{
+  if (n <= *pcap) return v;
+  int cap = (*pcap == 0) ? 64 : *pcap;
+  while (cap < n) cap *= 2;
+  v = realloc(v, cap * tam);
+  assert(v != NULL);
+  *pcap = cap;
+  return v;
+}
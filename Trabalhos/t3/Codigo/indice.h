@@ -0,0 +1,46 @@
+// indice.h
+// índice de nomes (tabela hash) e vetores que crescem
+// simulador de computador
+// so25b
+
+#ifndef INDICE_H
+#define INDICE_H
+
+// o índice associa nomes a valores inteiros (>= 0), em geral a posição do
+//   elemento com esse nome em um vetor de quem usa o índice
+// é uma tabela hash (FNV-1a) com endereçamento aberto (sondagem linear),
+//   mantida no máximo meio cheia
+// o índice não copia os nomes: cada nome inserido deve continuar existindo,
+//   sem ser alterado, enquanto o índice existir
+// é usado pelo montador (símbolos), pelas estatísticas (ver estat.h) e pelo
+//   perfil (ver perfil.h)
+
+#include <stddef.h>
+
+typedef struct indice_t indice_t;
+
+// cria um índice vazio
+indice_t *indice_cria(void);
+
+// destrói um índice (os nomes não são liberados)
+void indice_destroi(indice_t *self);
+
+// retorna o valor associado a 'nome', ou -1 se o nome não estiver no índice
+int indice_busca(indice_t *self, char *nome);
+
+// associa o valor 'valor' a 'nome', que não pode estar no índice
+void indice_insere(indice_t *self, char *nome, int valor);
+
+// esvazia o índice
+void indice_limpa(indice_t *self);
+
+// função hash FNV-1a de uma string
+unsigned indice_hash(char *s);
+
+// aumenta o vetor 'v' (com '*pcap' elementos de 'tam' bytes) para que tenha
+//   pelo menos 'n' elementos, e retorna o novo vetor (que pode ter mudado de
+//   lugar); a capacidade é dobrada para que o custo de inserir um elemento
+//   por vez seja constante (amortizado)
+void *vetor_cresce(void *v, int *pcap, int n, size_t tam);
+
+#endif // INDICE_H
@@ -1,17 +1,36 @@
 // metricas.c
 #include "metricas.h"
-#include "console.h"
+#include "depura.h"
+#include "relogio.h"
+#include "estat.h"
+#include "instrucao.h"
 #include <assert.h>
 #include <stdlib.h> 
 #include <stdio.h>
 
 
-// em so.c:
-//    #define N_PROCESSOS 5   // número máximo de processos
+// tamanho inicial dos vetores de processos (o número máximo de processos
+//   simultâneos no SO); os vetores crescem com o número de processos criados
 #define N_PROCESSOS 5
 
 metricas_t metricas;
 
+// estatísticas de cada processo (ver estat.h), obtidas na criação do
+//   processo, e não a cada mudança de estado; indexadas como os vetores de
+//   processos
+typedef struct {
+    estat_t *tempo_pronto;
+    estat_t *tempo_execucao;
+    estat_t *tempo_bloqueado;
+    estat_t *tempo_resposta;
+} estat_processo_t;
+static estat_processo_t *estat_processo;
+// estatísticas do sistema todo
+static estat_t *estat_tempo_resposta;
+static estat_t *estat_tempo_retorno;
+
+static void metricas_aumenta_vetores(metricas_t *m, int n);
+
 
 void inicializa_metricas(metricas_t *m)
 {
@@ -28,87 +47,273 @@ void inicializa_metricas(metricas_t *m)
     m->n_irq_desconhecida = 0;
 
     m->n_preempcoes = 0;
+    m->n_imagens_acertos = 0;
+    m->n_imagens_faltas = 0;
+
+    // vetores de processos, aumentados por metricas_aumenta_vetores
+    m->n_processos_cap = 0;
+    m->processos_pid = NULL;
+    m->tempo_retorno_processo = NULL;
+    m->processos_estado = NULL;
+    m->tempo_criacao = NULL;
+    m->data_mudanca_estado = NULL;
+    m->n_prontos = NULL;
+    m->tempo_pronto = NULL;
+    m->n_bloqueados = NULL;
+    m->tempo_bloqueado = NULL;
+    m->n_execucao = NULL;
+    m->tempo_execucao = NULL;
+    m->tempo_medio_resposta = NULL;
+    estat_processo = NULL;
+    metricas_aumenta_vetores(m, N_PROCESSOS);
+    estat_tempo_resposta = estat_histograma("tempo_resposta");
+    estat_tempo_retorno = estat_histograma("tempo_retorno");
+
+    m->so_oscioso = false;
+    m->data_oscioso = 0;
+}
+
+// aumenta um vetor de int de 'n_ant' para 'n' elementos, com 'valor' nos novos
+static int *aumenta_vetor(int *v, int n_ant, int n, int valor)
+{
+    v = (int*) realloc(v, n * sizeof(int));
+    assert(v != NULL);
+    for (int i = n_ant; i < n; i++)
+    {
+        v[i] = valor;
+    }
+    return v;
+}
+
+// garante que os vetores de processos tenham pelo menos 'n' elementos
+static void metricas_aumenta_vetores(metricas_t *m, int n)
+{
+    if (n <= m->n_processos_cap) return;
+    int ant = m->n_processos_cap;
+    if (n < 2 * ant) n = 2 * ant;
     // processos
-    m->processos_pid = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->processos_pid != NULL);
+    m->processos_pid = aumenta_vetor(m->processos_pid, ant, n, -1);  // sem processo
     // tempo de retorno de processos
-    m->tempo_retorno_processo = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->tempo_retorno_processo != NULL);
-    // estado dos processos
-    m->processos_estado = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->processos_estado != NULL);
+    m->tempo_retorno_processo = aumenta_vetor(m->tempo_retorno_processo, ant, n, 0);
+    // estado dos processos (4, finalizado: não conta tempo)
+    m->processos_estado = aumenta_vetor(m->processos_estado, ant, n, 4);
     // tempo de criação do processo
-    m->tempo_criacao = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->tempo_criacao != NULL);
-    // processos recem criados
-    m->processos_recem_criado = (bool*) calloc(N_PROCESSOS, sizeof(bool));
-    assert(m->processos_recem_criado != NULL);
-    // final do processo ja registrado
-    m->final_ja_registrado = (bool*) calloc(N_PROCESSOS, sizeof(bool));
-    assert(m->final_ja_registrado != NULL);
-
+    m->tempo_criacao = aumenta_vetor(m->tempo_criacao, ant, n, 0);
+    // data da última mudança de estado
+    m->data_mudanca_estado = aumenta_vetor(m->data_mudanca_estado, ant, n, 0);
     // n vezes prontos
-    m->n_prontos = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->n_prontos != NULL);
+    m->n_prontos = aumenta_vetor(m->n_prontos, ant, n, 0);
     // tempo pronto
-    m->tempo_pronto = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->tempo_pronto != NULL);
+    m->tempo_pronto = aumenta_vetor(m->tempo_pronto, ant, n, 0);
     // n vezes bloqueado
-    m->n_bloqueados = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->n_bloqueados != NULL);
+    m->n_bloqueados = aumenta_vetor(m->n_bloqueados, ant, n, 0);
     // tempo bloqueado
-    m->tempo_bloqueado = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->tempo_bloqueado != NULL);
+    m->tempo_bloqueado = aumenta_vetor(m->tempo_bloqueado, ant, n, 0);
     // n execuções
-    m->n_execucao = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->n_execucao != NULL);
+    m->n_execucao = aumenta_vetor(m->n_execucao, ant, n, 0);
     // tempo execução
-    m->tempo_execucao = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->tempo_execucao != NULL);
+    m->tempo_execucao = aumenta_vetor(m->tempo_execucao, ant, n, 0);
     // tempo resposta
-    m->tempo_medio_resposta = (int*) malloc(N_PROCESSOS * sizeof(int));
-    assert(m->tempo_medio_resposta != NULL);
+    m->tempo_medio_resposta = aumenta_vetor(m->tempo_medio_resposta, ant, n, 0);
+    // estatísticas (preenchidas na criação do processo)
+    estat_processo = realloc(estat_processo, n * sizeof(estat_processo_t));
+    assert(estat_processo != NULL);
+    m->n_processos_cap = n;
+}
+
+// soma ao tempo do estado atual do processo o tempo desde que ele entrou
+//   nesse estado ('i' é a posição nos vetores, o número do processo - 1)
+static void metricas_contabiliza_estado(int i, int agora)
+{
+    int tempo = agora - metricas.data_mudanca_estado[i];
+    switch (metricas.processos_estado[i]){
+        case 0:  // pronto
+            metricas.tempo_pronto[i] += tempo;
+            estat_soma(estat_processo[i].tempo_pronto, tempo);
+            break;
+        case 1:  // execução
+            metricas.tempo_execucao[i] += tempo;
+            estat_soma(estat_processo[i].tempo_execucao, tempo);
+            break;
+        case 3:  // bloqueado
+            metricas.tempo_bloqueado[i] += tempo;
+            estat_soma(estat_processo[i].tempo_bloqueado, tempo);
+            break;
+        default:  // espera (não foi pedido) ou finalizado
+            break;
+    }
+    metricas.data_mudanca_estado[i] = agora;
+}
+
+int metricas_processo_criado(int pid)
+{
+    int num = ++metricas.n_processos_criados;
+    int indice = num - 1;
+    metricas_aumenta_vetores(&metricas, num);
+    int agora = relogio_agora();
+    metricas.processos_pid[indice] = pid;
+    metricas.processos_estado[indice] = 0;  // pronto
+    metricas.data_mudanca_estado[indice] = agora;
+    metricas.tempo_criacao[indice] = agora;
+    metricas.n_prontos[indice]++;
+    estat_processo[indice].tempo_pronto = estat_contador("proc.%d.tempo_pronto", num);
+    estat_processo[indice].tempo_execucao = estat_contador("proc.%d.tempo_execucao", num);
+    estat_processo[indice].tempo_bloqueado = estat_contador("proc.%d.tempo_bloqueado", num);
+    estat_processo[indice].tempo_resposta = estat_histograma("proc.%d.tempo_resposta", num);
+    return num;
+}
 
-    for (int i = 0; i < N_PROCESSOS; i++)
+void metricas_muda_estado(int num, int estado)
+{
+    assert(num >= 1 && num <= metricas.n_processos_criados);
+    int indice = num - 1;
+    int agora = relogio_agora();
+    // tempo de resposta: da entrada na fila de prontos até ser escalonado
+    if (metricas.processos_estado[indice] == 0 && estado == 1)
     {
-        m->processos_pid[i] = -1;  // sem processo
-        m->tempo_retorno_processo[i] = 0;
-        m->n_prontos[i] = 0;
-        m->tempo_pronto[i] = 0;
-        m->n_bloqueados[i] = 0;
-        m->tempo_bloqueado[i] = 0;
-        m->n_execucao[i] = 0;
-        m->tempo_execucao[i] = 0;
-        m->tempo_medio_resposta[i] = 0;
+        int resposta = agora - metricas.data_mudanca_estado[indice];
+        estat_registra(estat_tempo_resposta, resposta);
+        estat_registra(estat_processo[indice].tempo_resposta, resposta);
+    }
+    metricas_contabiliza_estado(indice, agora);
+    metricas.processos_estado[indice] = estado;
+    switch (estado){
+        case 0:  // pronto
+            metricas.n_prontos[indice]++;
+            break;
+        case 1:  // execução
+            metricas.n_execucao[indice]++;
+            break;
+        case 3:  // bloqueado
+            metricas.n_bloqueados[indice]++;
+            break;
+        case 4:  // finalizado
+            metricas.tempo_retorno_processo[indice] = agora - metricas.tempo_criacao[indice];
+            depura(DEP_PROC, NIVEL_DETALHE, "métricas: processo %d terminou, tempo de retorno %d",
+                   num, metricas.tempo_retorno_processo[indice]);
+            estat_registra(estat_tempo_retorno, metricas.tempo_retorno_processo[indice]);
+            break;
     }
+}
 
-    m->so_oscioso = false;
+void metricas_define_oscioso(bool oscioso)
+{
+    int agora = relogio_agora();
+    if (metricas.so_oscioso) {
+        metricas.tempo_total_ocioso += agora - metricas.data_oscioso;
+    }
+    metricas.so_oscioso = oscioso;
+    metricas.data_oscioso = agora;
 }
 
 
-void metricas_imprime()
+// porcentagem de 'n' em 'total'
+static double pct(long n, long total)
+{
+    return total > 0 ? 100.0 * n / total : 0;
+}
+
+// imprime a mistura de instruções, com os opcodes do mais para o menos
+//   executado
+static void metricas_imprime_cpu(FILE *f, cpu_contadores_t *cpu)
 {
-    FILE *f = fopen("relatorio.txt", "w");
+    long total = cpu->modo[usuario] + cpu->modo[supervisor];
+    long desvios = cpu->desvios_tomados + cpu->desvios_nao_tomados;
+    fprintf(f, "- instruções: %ld, usuário[%ld %.1f%%], supervisor[%ld %.1f%%]\n",
+            total, cpu->modo[usuario], pct(cpu->modo[usuario], total),
+            cpu->modo[supervisor], pct(cpu->modo[supervisor], total));
+    fprintf(f, "- acessos à memória: leituras[%ld], escritas[%ld], por instrução[%.2f]\n",
+            cpu->leituras, cpu->escritas,
+            total > 0 ? (double)(cpu->leituras + cpu->escritas) / total : 0);
+    fprintf(f, "- desvios condicionais: tomados[%ld %.1f%%], não tomados[%ld]\n",
+            cpu->desvios_tomados, pct(cpu->desvios_tomados, desvios),
+            cpu->desvios_nao_tomados);
+    fprintf(f, "- irqs aceitas:");
+    for (int i = 0; i < N_IRQ; i++) {
+        fprintf(f, " %s[%ld]", irq_nome(i), cpu->irqs[i]);
+    }
+    fprintf(f, "\n");
+
+    int ordem[N_OPCODE];
+    for (int i = 0; i < N_OPCODE; i++) ordem[i] = i;
+    for (int i = 1; i < N_OPCODE; i++) {
+        for (int j = i; j > 0 && cpu->instrucoes[ordem[j]] > cpu->instrucoes[ordem[j - 1]]; j--) {
+            int t = ordem[j];
+            ordem[j] = ordem[j - 1];
+            ordem[j - 1] = t;
+        }
+    }
+    for (int i = 0; i < N_OPCODE && cpu->instrucoes[ordem[i]] > 0; i++) {
+        fprintf(f, "  %-7s %10ld %5.1f%%\n", instrucao_nome(ordem[i]),
+                cpu->instrucoes[ordem[i]], pct(cpu->instrucoes[ordem[i]], total));
+    }
+}
+
+void metricas_imprime(char *nome_arquivo, cpu_contadores_t *cpu)
+{
+    FILE *f = fopen(nome_arquivo, "w");
     if (f == NULL) 
     {
-        perror("Erro ao abrir relatorio.txt");
+        perror(nome_arquivo);
         return;
     }
 
+    // contabiliza os tempos até agora, dos estados que ainda não terminaram
+    int agora = relogio_agora();
+    metricas.tempo_total_execucao = agora;
+    metricas_define_oscioso(metricas.so_oscioso);
+    // só um processo executa de cada vez: a soma dos tempos de execução não
+    //   pode passar do tempo total (a espera na fila de prontos não conta)
+    long soma_execucao = 0;
+    for (int i = 0; i < metricas.n_processos_criados; i++)
+    {
+        metricas_contabiliza_estado(i, agora);
+        soma_execucao += metricas.tempo_execucao[i];
+    }
+    assert(soma_execucao <= metricas.tempo_total_execucao);
+
     fprintf(f, "- n processos criados: %d\n", metricas.n_processos_criados);
     fprintf(f, "- tempo total de execução: %d\n", metricas.tempo_total_execucao);
     fprintf(f, "- tempo total ocioso: %d\n", metricas.tempo_total_ocioso);
     fprintf(f, "- irqs: reset[%d], err_cpou[%d], sistema[%d], teclado[%d] tela[%d] relogio[%d], desconhecida[%d]\n",metricas.n_irq_reset, metricas.n_irq_err_cpu, metricas.n_irq_sistema, metricas.n_irq_teclado, metricas.n_irq_tela, metricas.n_irq_relogio, metricas.n_irq_desconhecida);
     fprintf(f, "- n preempções: %d\n", metricas.n_preempcoes);
+    fprintf(f, "- cache de imagens: acertos[%d], faltas[%d]\n", metricas.n_imagens_acertos, metricas.n_imagens_faltas);
 
     fprintf(f, "\nMétricas de processos:\n");
-    for (int i = 0; i < 4; i++) 
+    // um bloco por processo criado, na ordem de criação
+    for (int i = 0; i < metricas.n_processos_criados; i++) 
     {
-        fprintf(f, "Processo %d\n", i);
-        fprintf(f, "- tempo de retorno proc %d: %d\n",i - 1, metricas.tempo_retorno_processo[i]);
-        fprintf(f, "- n vezes em cada estado proc %d : pronto[%d], block[%d], exec[%d]\n", i - 1, metricas.n_prontos[i], metricas.n_bloqueados[i], metricas.n_execucao[i]);
-        fprintf(f, "- tempo em cada estado do proc %d : pronto[%d], block[%d], exec[%d]\n", i - 1, metricas.tempo_pronto[i], metricas.tempo_bloqueado[i], metricas.tempo_execucao[i]);
+        int num = i + 1;
+        fprintf(f, "Processo %d (pid %d)\n", num, metricas.processos_pid[i]);
+        fprintf(f, "- tempo de retorno proc %d: %d\n", num, metricas.tempo_retorno_processo[i]);
+        fprintf(f, "- n vezes em cada estado proc %d : pronto[%d], block[%d], exec[%d]\n", num, metricas.n_prontos[i], metricas.n_bloqueados[i], metricas.n_execucao[i]);
+        fprintf(f, "- tempo em cada estado do proc %d : pronto[%d], block[%d], exec[%d]\n", num, metricas.tempo_pronto[i], metricas.tempo_bloqueado[i], metricas.tempo_execucao[i]);
     }
 
+    fprintf(f, "\nMistura de instruções:\n");
+    metricas_imprime_cpu(f, cpu);
+
+    // histogramas de tempo de resposta e de latência, no total e por processo
+    fprintf(f, "\nLatências:\n");
+    estat_imprime_histogramas(f);
+
     fclose(f);
-}
\ No newline at end of file
+}
+
+void metricas_imprime_resumo(FILE *f, double segundos)
+{
+    estat_t *retorno = estat_histograma("tempo_retorno");
+    int instrucoes = relogio_agora();
+    long faltas = estat_valor(estat_contador("mem.faltas_pagina"));
+    fprintf(f, "instrucoes=%d segundos=%.3f instr_por_seg=%.0f",
+            instrucoes, segundos, segundos > 0 ? instrucoes / segundos : 0);
+    fprintf(f, " ocioso=%d processos=%d preempcoes=%d",
+            metricas.tempo_total_ocioso, metricas.n_processos_criados,
+            metricas.n_preempcoes);
+    fprintf(f, " faltas=%ld faltas_por_mil=%.2f carregadas=%ld gravadas=%ld",
+            faltas, instrucoes > 0 ? 1000.0 * faltas / instrucoes : 0,
+            estat_valor(estat_contador("mem.paginas_carregadas")),
+            estat_valor(estat_contador("mem.paginas_gravadas")));
+    fprintf(f, " terminados=%ld retorno_medio=%.0f retorno_max=%ld\n",
+            estat_valor(retorno), estat_media(retorno), estat_percentil(retorno, 100));
+}
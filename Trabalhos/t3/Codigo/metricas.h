@@ -2,7 +2,10 @@
 #define METRICAS_H
 
 
+#include "cpu.h"
+
 #include <stdbool.h>
+#include <stdio.h>
 
 
 typedef struct metricas {
@@ -19,6 +22,9 @@ typedef struct metricas {
     int n_irq_desconhecida;
 
     int n_preempcoes;
+    // cache de imagens de programas do SO
+    int n_imagens_acertos;
+    int n_imagens_faltas;
     int *tempo_retorno_processo;
     int *n_prontos;
     int *tempo_pronto;
@@ -30,12 +36,13 @@ typedef struct metricas {
 
     // informação relevante sobre o estado do so
     bool so_oscioso;        // todos os processos estão bloqueados
+    int data_oscioso;       // data em que so_oscioso mudou pela última vez
     // informações relevante sobre o estado dos processos
     int *processos_pid;
     int *processos_estado;
     int *tempo_criacao;
-    bool *processos_recem_criado;
-    bool *final_ja_registrado;
+    int *data_mudanca_estado;   // data em que o processo entrou no estado atual
+    int n_processos_cap;        // tamanho dos vetores de processos
      
 } metricas_t;
 
@@ -47,7 +54,35 @@ extern metricas_t metricas;
 // inicializa os campos da struct métricas
 void inicializa_metricas(metricas_t *m);
 
-// imprime as metricas
-void metricas_imprime();
+// os tempos são contabilizados nas mudanças de estado: cada mudança soma
+//   ao tempo do estado anterior o tempo desde a mudança anterior (com
+//   relogio_agora), e os vetores de processos crescem conforme o necessário
+// os processos são identificados pelo número de criação (1 para o primeiro
+//   processo criado), e não pela posição na tabela de processos do SO, que
+//   é reusada: cada processo tem as suas métricas, qualquer que seja o
+//   número de processos criados
+// os vetores de processos são indexados pelo número - 1
+
+// registra a criação do processo 'pid' (no estado pronto)
+// retorna o número do processo
+int metricas_processo_criado(int pid);
+
+// registra a mudança do estado do processo número 'num' para 'estado' (um
+//   estado_t do SO)
+// a mudança para o mesmo estado também é contada
+void metricas_muda_estado(int num, int estado);
+
+// registra se o SO está ocioso (todos os processos bloqueados)
+void metricas_define_oscioso(bool oscioso);
+
+// imprime as metricas no arquivo 'nome_arquivo', com a mistura de
+//   instruções dos contadores da CPU 'cpu'
+void metricas_imprime(char *nome_arquivo, cpu_contadores_t *cpu);
+
+// imprime em 'f' um resumo dos resultados da simulação, em uma linha com
+//   pares nome=valor (ver config.h)
+// 'segundos' é o tempo que a simulação levou no computador hospedeiro, para
+//   o cálculo de instruções simuladas por segundo
+void metricas_imprime_resumo(FILE *f, double segundos);
 
 #endif  // METRICAS_H
\ No newline at end of file
@@ -4,6 +4,7 @@
 // so25b
 
 #include "mmu.h"
+#include "cronometro.h"
 #include <stdlib.h>
 #include <assert.h>
 
@@ -13,15 +14,29 @@ struct mmu_t {
   mem_t *mem;
   // tabela de páginas
   tabpag_t *tabpag;
+  // tamanho de uma página; se for potência de 2, 'bits' é o log2 do
+  //   tamanho e 'mascara' seleciona o deslocamento dentro da página,
+  //   senão 'bits' é -1
+  int tam_pagina;
+  int bits;
+  int mascara;
 };
 
-mmu_t *mmu_cria(mem_t *mem)
+mmu_t *mmu_cria(mem_t *mem, int tam_pagina)
 {
+  assert(tam_pagina > 0);
   mmu_t *self;
   self = malloc(sizeof(*self));
   assert(self != NULL);
   self->mem = mem;
   self->tabpag = NULL;
+  self->tam_pagina = tam_pagina;
+  self->bits = -1;
+  self->mascara = 0;
+  if ((tam_pagina & (tam_pagina - 1)) == 0) {
+    self->bits = __builtin_ctz(tam_pagina);
+    self->mascara = tam_pagina - 1;
+  }
   return self;
 }
 
@@ -33,58 +48,88 @@ void mmu_destroi(mmu_t *self)
   }
 }
 
+int mmu_tam_pagina(mmu_t *self)
+{
+  return self->tam_pagina;
+}
+
 void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag)
 {
   self->tabpag = tabpag;
 }
 
+int mmu_pagina(mmu_t *self, int endvirt)
+{
+  if (endvirt < 0) return -1;
+  if (self->bits >= 0) return endvirt >> self->bits;
+  return endvirt / self->tam_pagina;
+}
+
 // traduz o endereço virtual 'endvirt', colocando o endereço físico
-//   correspondente em 'pendfis'.
+//   correspondente em 'pendfis' e a página em 'ppagina'.
 // retorna ERR_OK ou um erro se a tradução não for possível
-static err_t mmu__traduz(mmu_t *self, int endvirt, int *pendfis)
+// endereços negativos são recusados: com a divisão, -3 / 10 seria a
+//   página 0 com deslocamento -3, no fim do quadro anterior
+static err_t mmu__traduz(mmu_t *self, int endvirt, int *pendfis, int *ppagina)
 {
-  int pagina = endvirt / TAM_PAGINA;
-  int deslocamento = endvirt % TAM_PAGINA;
+  if (endvirt < 0) return ERR_PAG_AUSENTE;
+  int pagina, deslocamento;
+  if (self->bits >= 0) {
+    pagina = endvirt >> self->bits;
+    deslocamento = endvirt & self->mascara;
+  } else {
+    pagina = endvirt / self->tam_pagina;
+    deslocamento = endvirt % self->tam_pagina;
+  }
   int quadro;
   err_t err = tabpag_traduz(self->tabpag, pagina, &quadro);
   if (err == ERR_OK) {
-    *pendfis = quadro * TAM_PAGINA + deslocamento;
+    *pendfis = quadro * self->tam_pagina + deslocamento;
+    *ppagina = pagina;
   }
   return err;
 }
 
 err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
 {
+  CRONOMETRO_INICIO(t);
+  err_t err;
   // em modo supervisor ou se não tiver tabela de páginas,
   //   não faz tradução de endereços, nem marca o acesso
   if (modo == supervisor || self->tabpag == NULL) {
-    return mem_le(self->mem, endvirt, pvalor);
-  }
-  int endfis;
-  err_t err = mmu__traduz(self, endvirt, &endfis);
-  if (err == ERR_OK) {
-    err = mem_le(self->mem, endfis, pvalor);
+    err = mem_le(self->mem, endvirt, pvalor);
+  } else {
+    int endfis, pagina;
+    err = mmu__traduz(self, endvirt, &endfis, &pagina);
     if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, false);
+      err = mem_le(self->mem, endfis, pvalor);
+      if (err == ERR_OK) {
+        tabpag_marca_bit_acesso(self->tabpag, pagina, false);
+      }
     }
   }
+  CRONOMETRO_FIM(CRONO_MMU, t);
   return err;
 }
 
 err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
 {
+  CRONOMETRO_INICIO(t);
+  err_t err;
   // em modo supervisor ou se não tiver tabela de páginas,
   //   não faz tradução de endereços, nem marca o acesso
   if (modo == supervisor || self->tabpag == NULL) {
-    return mem_escreve(self->mem, endvirt, valor);
-  }
-  int endfis;
-  err_t err = mmu__traduz(self, endvirt, &endfis);
-  if (err == ERR_OK) {
-    err = mem_escreve(self->mem, endfis, valor);
+    err = mem_escreve(self->mem, endvirt, valor);
+  } else {
+    int endfis, pagina;
+    err = mmu__traduz(self, endvirt, &endfis, &pagina);
     if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, true);
+      err = mem_escreve(self->mem, endfis, valor);
+      if (err == ERR_OK) {
+        tabpag_marca_bit_acesso(self->tabpag, pagina, true);
+      }
     }
   }
+  CRONOMETRO_FIM(CRONO_MMU, t);
   return err;
 }
@@ -19,21 +19,29 @@ typedef struct mmu_t mmu_t;
 #include "err.h"
 #include "cpu.h"
 
-// tamanho de uma página, em palavras de memória
-// t3: pode ser alterado para comparar configurações diferentes
-#define TAM_PAGINA 10
-
 // cria uma MMU para gerenciar acessos à memória
 // retorna um ponteiro para um descritor, que deverá ser usado em todas
 //   as operações nessa MMU
-// recebe 'mem', a memória física que será gerenciada
+// recebe 'mem', a memória física que será gerenciada, e 'tam_pagina', o
+//   tamanho de uma página (e de um quadro), em palavras de memória
+// se 'tam_pagina' for uma potência de 2, a tradução de endereços é feita
+//   com deslocamento de bits e máscara em vez de divisão e resto
 // mata o programa em caso de erro (malloc)
-mmu_t *mmu_cria(mem_t *mem);
+mmu_t *mmu_cria(mem_t *mem, int tam_pagina);
 
 // destrói uma MMU
 // nenhuma outra operação pode ser realizada na MMU após esta chamada
 void mmu_destroi(mmu_t *self);
 
+// retorna o tamanho de página da MMU
+// t3: pode ser alterado (na configuração) para comparar configurações diferentes
+int mmu_tam_pagina(mmu_t *self);
+
+// retorna a página do endereço virtual 'endvirt', calculada como na
+//   tradução, ou -1 se o endereço for negativo (não está em nenhuma página;
+//   o acesso a ele resulta em ERR_PAG_AUSENTE)
+int mmu_pagina(mmu_t *self, int endvirt);
+
 // define a tabela de páginas a usar nas próximas traduções
 // se tabpag for NULL, os acessos serão repassados à memória sem alteração
 void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag);
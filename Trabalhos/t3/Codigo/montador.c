@@ -8,12 +8,17 @@
 // ---------------------------------------------------------------------
 
 #include "instrucao.h"
+#include "programa.h"
+#include "indice.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 
 // ---------------------------------------------------------------------
@@ -43,49 +48,148 @@ bool tem_numero(char *s, int *num)
 
 
 // ---------------------------------------------------------------------
-// MEMÓRIA DE SAÍDA {{{1
+// CONTEXTO DE UMA MONTAGEM {{{1
 // ---------------------------------------------------------------------
 
-// representa a memória do programa -- a saída do montador é colocada aqui
+// símbolo (label), ver SÍMBOLOS
+typedef struct {
+  char *nome;
+  int valor;
+  bool definido;
+  // para o mapa de símbolos (ver MAPA DE SÍMBOLOS)
+  bool rotulo;          // definido como label de uma linha (é um endereço)
+  bool chamado;         // é argumento de algum CHAMA
+  int fim;              // endereço depois do último 'RET simbolo', ou -1
+} simbolo_t;
+
+// referência a um símbolo, ver REFERÊNCIAS
+typedef struct {
+  int simb;
+  int linha;
+  int endereco;
+} ref_t;
+
+// todo o estado da montagem de um arquivo; várias montagens podem ser
+//   feitas ao mesmo tempo (em threads diferentes), cada uma com o seu
+typedef struct {
+  char *fonte;          // nome do arquivo fonte
+  bool fonte_no_erro;   // identifica o arquivo nas mensagens de erro
+
+  // memória do programa -- a saída do montador é colocada aqui
+  // o vetor é indexado pelo endereço, e cresce conforme o necessário
+  int *mem;
+  int mem_cap;          // tamanho do vetor mem
+  int mem_pos;          // próxima posição livre da memória
+  int mem_min;          // menor endereço preenchido
+  int mem_max;          // maior endereço preenchido
+
+  // tabela de símbolos e índice para encontrá-los pelo nome
+  simbolo_t *simbolo;
+  int simb_num;         // número de símbolos na tabela
+  int simb_cap;         // tamanho do vetor simbolo
+  indice_t *simb_indice;
+
+  // tabela de referências
+  ref_t *ref;
+  int ref_num;          // numero de referências criadas
+  int ref_cap;          // tamanho do vetor ref
+} montagem_t;
+
+// inicializa uma montagem do arquivo 'fonte', a partir do endereço 'end'
+void montagem_inicia(montagem_t *m, char *fonte, int end)
+{
+  memset(m, 0, sizeof(*m));
+  m->fonte = fonte;
+  m->mem_pos = end;
+  m->mem_min = -1;
+  m->mem_max = -1;
+  m->simb_indice = indice_cria();
+}
+
+// libera a memória usada por uma montagem
+void montagem_termina(montagem_t *m)
+{
+  for (int i = 0; i < m->simb_num; i++) free(m->simbolo[i].nome);
+  free(m->simbolo);
+  indice_destroi(m->simb_indice);
+  free(m->ref);
+  free(m->mem);
+}
+
+// imprime uma mensagem de erro da montagem
+void erro(montagem_t *m, char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  flockfile(stderr);
+  if (m->fonte_no_erro) fprintf(stderr, "%s: ", m->fonte);
+  vfprintf(stderr, fmt, ap);
+  funlockfile(stderr);
+  va_end(ap);
+}
+
+// opções da linha de comando
+bool saida_binaria = false;  // gera o .maq no formato binário (ver programa.h)
+bool gera_simbolos = false;  // gera o mapa de símbolos (ver MAPA DE SÍMBOLOS)
 
-#define MEM_TAM 10000    // aumentar para programas maiores
-int mem[MEM_TAM];
-int mem_pos = 0;        // próxima posição livre da memória
-int mem_min = -1;       // menor endereço preenchido
-int mem_max = -1;       // maior endereço preenchido
 
-char *nome_fonte;   // nome do arquivo fonte a montar
+// ---------------------------------------------------------------------
+// MEMÓRIA DE SAÍDA {{{1
+// ---------------------------------------------------------------------
 
 // coloca um valor no final da memória
-void mem_insere(int val)
+void mem_insere(montagem_t *m, int val)
 {
-  if (mem_pos >= MEM_TAM-1) {
-    erro_brabo("programa muito grande! Aumente MEM_TAM no montador.");
-  }
-  if (mem_min == -1 || mem_pos < mem_min) mem_min = mem_pos;
-  if (mem_max == -1 || mem_pos > mem_max) mem_max = mem_pos;
-  mem[mem_pos++] = val;
+  m->mem = vetor_cresce(m->mem, &m->mem_cap, m->mem_pos + 1, sizeof(int));
+  if (m->mem_min == -1 || m->mem_pos < m->mem_min) m->mem_min = m->mem_pos;
+  if (m->mem_max == -1 || m->mem_pos > m->mem_max) m->mem_max = m->mem_pos;
+  m->mem[m->mem_pos++] = val;
 }
 
 // altera o valor em uma posição já ocupada da memória
-void mem_altera(int pos, int val)
+void mem_altera(montagem_t *m, int pos, int val)
 {
-  if (pos < mem_min || pos > mem_max) {
+  if (pos < m->mem_min || pos > m->mem_max) {
     erro_brabo("erro interno, alteração de região não inicializada");
   }
-  mem[pos] = val;
+  m->mem[pos] = val;
+}
+
+// escreve uma palavra de 4 bytes em little-endian na saída
+static void escreve_palavra(FILE *f, int32_t val)
+{
+  unsigned char b[4] = { val & 0xff, (val >> 8) & 0xff,
+                         (val >> 16) & 0xff, (val >> 24) & 0xff };
+  fwrite(b, 1, 4, f);
+}
+
+// escreve o conteúdo da memória no formato binário (ver programa.h)
+// os zeros no final do programa não são escritos, só contados no cabeçalho
+void mem_escreve_binario(montagem_t *m, FILE *f)
+{
+  int tam = m->mem_max - m->mem_min + 1;
+  int n_zeros = 0;
+  while (n_zeros < tam && m->mem[m->mem_max - n_zeros] == 0) n_zeros++;
+  escreve_palavra(f, PROG_MAGICO);
+  escreve_palavra(f, m->mem_min);
+  escreve_palavra(f, tam);
+  escreve_palavra(f, m->mem_min);
+  escreve_palavra(f, n_zeros);
+  for (int i = m->mem_min; i <= m->mem_max - n_zeros; i++) {
+    escreve_palavra(f, m->mem[i]);
+  }
 }
 
 // imprime o conteúdo da memória
-void mem_imprime(void)
+void mem_imprime(montagem_t *m, FILE *f)
 {
-  printf("//MAQ %d %d\n", mem_max - mem_min + 1, mem_min);
-  for (int i = mem_min; i <= mem_max; i+=10) {
-    printf("[%4d] =", i);
-    for (int j = i; j < i+10 && j <= mem_max; j++) {
-      printf(" %d,", mem[j]);
+  fprintf(f, "//MAQ %d %d\n", m->mem_max - m->mem_min + 1, m->mem_min);
+  for (int i = m->mem_min; i <= m->mem_max; i+=10) {
+    fprintf(f, "[%4d] =", i);
+    for (int j = i; j < i+10 && j <= m->mem_max; j++) {
+      fprintf(f, " %d,", m->mem[j]);
     }
-    printf("\n");
+    fprintf(f, "\n");
   }
 }
 
@@ -94,40 +198,53 @@ void mem_imprime(void)
 // SÍMBOLOS {{{1
 // ---------------------------------------------------------------------
 
-// tabela com os símbolos (labels) já definidos pelo programa, e o valor (endereço) deles
-
-#define SIMB_TAM 1000
-struct {
-  char *nome;
-  int valor;
-} simbolo[SIMB_TAM];
-int simb_num;             // número d símbolos na tabela
+// tabela com os símbolos (labels) usados pelo programa, e o valor (endereço)
+//   dos que já foram definidos
+// cada nome é guardado uma vez só (na primeira definição ou referência), e é
+//   identificado pela sua posição no vetor simbolo; referências guardam essa
+//   posição, e não o nome
+// os nomes são encontrados pelo índice simb_indice (ver indice.h), que
+//   contém posições em simbolo
+
+// retorna a posição do símbolo 'nome' na tabela, inserindo (não definido)
+//   se ainda não existir
+int simb_id(montagem_t *m, char *nome)
+{
+  int id = indice_busca(m->simb_indice, nome);
+  if (id != -1) return id;
+  m->simbolo = vetor_cresce(m->simbolo, &m->simb_cap, m->simb_num + 1, sizeof(simbolo_t));
+  simbolo_t *s = &m->simbolo[m->simb_num];
+  s->nome = strdup(nome);
+  if (s->nome == NULL) erro_brabo("falta de memória no montador");
+  s->valor = -1;
+  s->definido = false;
+  s->rotulo = false;
+  s->chamado = false;
+  s->fim = -1;
+  indice_insere(m->simb_indice, s->nome, m->simb_num);
+  return m->simb_num++;
+}
 
-// retorna o valor de um símbolo, ou -1 se não existir na tabela
-int simb_valor(char *nome)
+// retorna o valor de um símbolo, ou -1 se não estiver definido
+int simb_valor(montagem_t *m, char *nome)
 {
-  for (int i=0; i<simb_num; i++) {
-    if (strcmp(nome, simbolo[i].nome) == 0) {
-      return simbolo[i].valor;
-    }
-  }
-  return -1;
+  // simb_id pode realocar o vetor simbolo
+  int id = simb_id(m, nome);
+  return m->simbolo[id].definido ? m->simbolo[id].valor : -1;
 }
 
-// insere um novo símbolo na tabela
-void simb_novo(char *nome, int valor)
+// define um novo símbolo na tabela
+void simb_novo(montagem_t *m, char *nome, int valor)
 {
   if (nome == NULL) return;
-  if (simb_valor(nome) != -1) {
-    fprintf(stderr, "ERRO: redefinicao do simbolo '%s'\n", nome);
+  int id = simb_id(m, nome);
+  simbolo_t *s = &m->simbolo[id];
+  if (s->definido) {
+    erro(m, "ERRO: redefinicao do simbolo '%s'\n", nome);
     return;
   }
-  if (simb_num >= SIMB_TAM) {
-    erro_brabo("Excesso de símbolos. Aumente SIMB_TAM no montador.");
-  }
-  simbolo[simb_num].nome = strdup(nome);
-  simbolo[simb_num].valor = valor;
-  simb_num++;
+  s->valor = valor;
+  s->definido = true;
 }
 
 
@@ -136,41 +253,33 @@ void simb_novo(char *nome, int valor)
 // ---------------------------------------------------------------------
 
 // tabela com referências a símbolos
-//   contém a linha e o endereço onde o símbolo foi referenciado
-
-#define REF_TAM 1000
-struct {
-  char *nome;
-  int linha;
-  int endereco;
-} ref[REF_TAM];
-int ref_num;      // numero de referências criadas
+//   contém o símbolo (posição na tabela de símbolos), a linha e o endereço
+//   onde o símbolo foi referenciado
 
 // insere uma nova referência na tabela
-void ref_nova(char *nome, int linha, int endereco)
+void ref_nova(montagem_t *m, char *nome, int linha, int endereco)
 {
   if (nome == NULL) return;
-  if (ref_num >= REF_TAM) {
-    erro_brabo("excesso de referências. Aumente REF_TAM no montador.");
-  }
-  ref[ref_num].nome = strdup(nome);
-  ref[ref_num].linha = linha;
-  ref[ref_num].endereco = endereco;
-  ref_num++;
+  int simb = simb_id(m, nome);
+  m->ref = vetor_cresce(m->ref, &m->ref_cap, m->ref_num + 1, sizeof(ref_t));
+  m->ref[m->ref_num].simb = simb;
+  m->ref[m->ref_num].linha = linha;
+  m->ref[m->ref_num].endereco = endereco;
+  m->ref_num++;
 }
 
 // resolve as referências -- para cada referência, coloca o valor do símbolo
 //   no endereço onde ele é referenciado
-void ref_resolve(void)
-{
-  for (int i=0; i<ref_num; i++) {
-    int valor = simb_valor(ref[i].nome);
-    if (valor == -1) {
-      fprintf(stderr, 
-              "ERRO: simbolo '%s' referenciado na linha %d não foi definido\n",
-              ref[i].nome, ref[i].linha);
+void ref_resolve(montagem_t *m)
+{
+  for (int i=0; i<m->ref_num; i++) {
+    simbolo_t *s = &m->simbolo[m->ref[i].simb];
+    int valor = s->definido ? s->valor : -1;
+    if (!s->definido) {
+      erro(m, "ERRO: simbolo '%s' referenciado na linha %d não foi definido\n",
+           s->nome, m->ref[i].linha);
     }
-    mem_altera(ref[i].endereco, valor);
+    mem_altera(m, m->ref[i].endereco, valor);
   }
 }
 
@@ -181,7 +290,7 @@ void ref_resolve(void)
 
 // realiza a montagem de uma instrução (gera o código para ela na memória),
 //   tendo opcode da instrução e o argumento
-void monta_instrucao(int linha, int opcode, char *arg)
+void monta_instrucao(montagem_t *m, int linha, int opcode, char *arg)
 {
   int argn;  // para conter o valor numérico do argumento
   int num_args = instrucao_num_args(opcode);
@@ -189,15 +298,15 @@ void monta_instrucao(int linha, int opcode, char *arg)
   // trata pseudo-opcodes antes
   if (opcode == ESPACO) {
     if (!tem_numero(arg, &argn)) {
-      argn = simb_valor(arg);
+      argn = simb_valor(m, arg);
     }
     if (argn < 1) {
-      fprintf(stderr, "ERRO: linha %d 'ESPACO' deve ter valor positivo\n",
+      erro(m, "ERRO: linha %d 'ESPACO' deve ter valor positivo\n",
               linha);
       return;
     }
     for (int i = 0; i < argn; i++) {
-      mem_insere(0);
+      mem_insere(m, 0);
     }
     return;
   } else if (opcode == VALOR) {
@@ -206,76 +315,83 @@ void monta_instrucao(int linha, int opcode, char *arg)
     char c;
     do {
       c = *++arg;
-      mem_insere(c);
+      mem_insere(m, c);
     } while(c != '\0');
     return;
   } else {
     // instrução real, coloca o opcode da instrução na memória
-    mem_insere(opcode);
+    mem_insere(m, opcode);
   }
   if (num_args == 0) {
     return;
   }
   if (tem_numero(arg, &argn)) {
-    mem_insere(argn);
+    mem_insere(m, argn);
   } else {
     // não é número, põe um 0 e insere uma referência para alterar depois
-    ref_nova(arg, linha, mem_pos);
-    mem_insere(0);
+    ref_nova(m, arg, linha, m->mem_pos);
+    mem_insere(m, 0);
+    // CHAMA e RET delimitam as subrotinas, para o mapa de símbolos
+    if (opcode == CHAMA) {
+      m->simbolo[simb_id(m, arg)].chamado = true;
+    } else if (opcode == RET) {
+      m->simbolo[simb_id(m, arg)].fim = m->mem_pos;
+    }
   }
 }
 
 // monta uma linha "label DEFINE arg", define o símbolo 'label' com valor 'arg'
-void monta_define(int linha, char *label, char *arg)
+void monta_define(montagem_t *m, int linha, char *label, char *arg)
 {
   int argn;  // para conter o valor numérico do argumento
   if (label == NULL) {
-    fprintf(stderr, "ERRO: linha %d: 'DEFINE' exige um label\n", linha);
+    erro(m, "ERRO: linha %d: 'DEFINE' exige um label\n", linha);
   } else if (!tem_numero(arg, &argn)) {
-    fprintf(stderr, "ERRO: linha %d 'DEFINE' exige valor numérico\n", linha);
+    erro(m, "ERRO: linha %d 'DEFINE' exige valor numérico\n", linha);
   } else {
     // tudo OK, define o símbolo
-    simb_novo(label, argn);
+    simb_novo(m, label, argn);
   }
 }
 
 // monta uma linha "label instrucao arg"
-void monta_linha(int linha, char *label, char *instrucao, char *arg)
+void monta_linha(montagem_t *m, int linha, char *label, char *instrucao, char *arg)
 {
   int opcode = instrucao_opcode(instrucao);
   // pseudo-instrução DEFINE tem que ser tratada antes, porque não pode
   //   definir o label de forma normal
   if (opcode == DEFINE) {
-    monta_define(linha, label, arg);
+    monta_define(m, linha, label, arg);
     return;
   }
   
   // cria símbolo correspondente ao label, se for o caso
   if (label != NULL) {
-    simb_novo(label, mem_pos);
+    simb_novo(m, label, m->mem_pos);
+    m->simbolo[simb_id(m, label)].rotulo = true;
   }
   
   // verifica a existência de instrução e número correto de argumentos
   if (instrucao == NULL) return;
   if (opcode == -1) {
-    fprintf(stderr, "ERRO: linha %d: instrucao '%s' desconhecida\n",
+    erro(m, "ERRO: linha %d: instrucao '%s' desconhecida\n",
                     linha, instrucao);
     return;
   }
   int num_args = instrucao_num_args(opcode);
   if (num_args == 0 && arg != NULL) {
-    fprintf(stderr, "ERRO: linha %d: instrucao '%s' não tem argumento\n",
+    erro(m, "ERRO: linha %d: instrucao '%s' não tem argumento\n",
                     linha, instrucao);
     return;
   }
   if (num_args == 1 && arg == NULL) {
-    fprintf(stderr, "ERRO: linha %d: instrucao '%s' necessita argumento\n",
+    erro(m, "ERRO: linha %d: instrucao '%s' necessita argumento\n",
                     linha, instrucao);
     return;
   }
 
   // tudo OK, monta a instrução
-  monta_instrucao(linha, opcode, arg);
+  monta_instrucao(m, linha, opcode, arg);
 }
 
 // retorna true se o caractere for um espaço (ou tab)
@@ -334,7 +450,7 @@ void tira_comentario(char *s)
 // de ';' em diante, ignora-se (comentário)
 // a string é alterada, colocando-se NULs no lugar dos espaços, para separá-la em substrings
 // quem precisar guardar essas substrings, deve copiá-las.
-void monta_string(int linha, char *str)
+void monta_string(montagem_t *m, int linha, char *str)
 {
   char *label = NULL;
   char *instrucao = NULL;
@@ -361,31 +477,234 @@ void monta_string(int linha, char *str)
   }
   str = detona_espacos(str);
   if (*str != '\0') {
-    fprintf(stderr, "linha %d: ignorando '%s'\n", linha, str);
+    erro(m, "linha %d: ignorando '%s'\n", linha, str);
   }
   if (label != NULL || instrucao != NULL) {
-    monta_linha(linha, label, instrucao, arg);
+    monta_linha(m, linha, label, instrucao, arg);
   }
 }
 
-void monta_arquivo(char *nome)
+// monta o arquivo fonte da montagem
+// retorna false se não foi possível ler o arquivo
+bool monta_arquivo(montagem_t *m)
 {
   FILE *arq;
-  arq = fopen(nome, "r");
+  arq = fopen(m->fonte, "r");
   if (arq == NULL) {
-    fprintf(stderr, "Não foi possível abrir o arquivo '%s'\n", nome);
-    return;
+    erro(m, "Não foi possível abrir o arquivo '%s'\n", m->fonte);
+    return false;
   }
   int nlinha = 1;
   char *linha = NULL;
   size_t nbytes;
   while (getline(&linha, &nbytes, arq) != -1) {
-    monta_string(nlinha, linha);
+    monta_string(m, nlinha, linha);
     nlinha++;
   }
   free(linha);
   fclose(arq);
-  ref_resolve();
+  ref_resolve(m);
+  return true;
+}
+
+
+// ---------------------------------------------------------------------
+// MAPA DE SÍMBOLOS {{{1
+// ---------------------------------------------------------------------
+
+// com a opção -s, o montador gera, junto com cada programa, um arquivo com
+//   os seus labels e endereços, usado pelo perfil do simulador (ver
+//   simbolos.h); o arquivo tem o nome do .maq (ou do .asm, se o programa
+//   for para a saída padrão) com a extensão trocada para .simb
+// cada linha tem o endereço, o fim e o nome de um label; o fim é -1, a
+//   menos que o label seja de uma subrotina (argumento de CHAMA ou RET),
+//   e nesse caso é o endereço depois da última instrução 'RET label'
+
+// coloca em 'nome' (com 'tam' bytes) o nome do arquivo de símbolos
+//   correspondente ao arquivo 'arquivo'
+static void nome_simbolos(char *arquivo, char *nome, int tam)
+{
+  char *ponto = strrchr(arquivo, '.');
+  char *barra = strrchr(arquivo, '/');
+  int n = strlen(arquivo);
+  if (ponto != NULL && (barra == NULL || ponto > barra)) n = ponto - arquivo;
+  snprintf(nome, tam, "%.*s.simb", n, arquivo);
+}
+
+static int compara_simbolos(const void *a, const void *b)
+{
+  const simbolo_t *sa = a, *sb = b;
+  return sa->valor - sb->valor;
+}
+
+// escreve o mapa de símbolos da montagem
+// retorna false se não foi possível criar o arquivo
+bool simbolos_escreve(montagem_t *m, char *arquivo)
+{
+  char nome[FILENAME_MAX];
+  nome_simbolos(arquivo, nome, sizeof(nome));
+  FILE *f = fopen(nome, "w");
+  if (f == NULL) {
+    erro(m, "Não foi possível criar o arquivo '%s'\n", nome);
+    return false;
+  }
+  // só os labels de linhas, em ordem de endereço
+  simbolo_t *rotulos = malloc((m->simb_num + 1) * sizeof(simbolo_t));
+  if (rotulos == NULL) erro_brabo("falta de memória no montador");
+  int n = 0;
+  for (int i = 0; i < m->simb_num; i++) {
+    if (m->simbolo[i].definido && m->simbolo[i].rotulo) rotulos[n++] = m->simbolo[i];
+  }
+  qsort(rotulos, n, sizeof(simbolo_t), compara_simbolos);
+  fprintf(f, "# símbolos de %s: endereço fim nome\n", m->fonte);
+  for (int i = 0; i < n; i++) {
+    bool rotina = rotulos[i].chamado || rotulos[i].fim >= 0;
+    fprintf(f, "%d %d %s\n", rotulos[i].valor, rotina ? rotulos[i].fim : -1, rotulos[i].nome);
+  }
+  free(rotulos);
+  return fclose(f) == 0;
+}
+
+
+// ---------------------------------------------------------------------
+// PROGRAMA {{{1
+// ---------------------------------------------------------------------
+
+// monta o programa em 'fonte' a partir do endereço 'end', e escreve o
+//   resultado no arquivo 'saida' (ou na saída padrão, se for NULL)
+// retorna false se não foi possível ler a fonte ou escrever a saída
+bool monta_programa(char *fonte, int end, char *saida, bool fonte_no_erro)
+{
+  montagem_t m;
+  montagem_inicia(&m, fonte, end);
+  m.fonte_no_erro = fonte_no_erro;
+  bool ok = monta_arquivo(&m);
+  if (ok) {
+    FILE *f = stdout;
+    if (saida != NULL) f = fopen(saida, "w");
+    if (f == NULL) {
+      erro(&m, "Não foi possível criar o arquivo '%s'\n", saida);
+      ok = false;
+    } else {
+      if (saida_binaria) {
+        mem_escreve_binario(&m, f);
+      } else {
+        mem_imprime(&m, f);
+      }
+      if (saida != NULL && fclose(f) != 0) ok = false;
+    }
+  }
+  if (ok && gera_simbolos) {
+    ok = simbolos_escreve(&m, (saida != NULL) ? saida : fonte);
+  }
+  montagem_termina(&m);
+  return ok;
+}
+
+
+// ---------------------------------------------------------------------
+// MONTAGEM EM LOTE {{{1
+// ---------------------------------------------------------------------
+
+// com a opção -m, o montador lê um manifesto com vários programas a montar,
+//   um por linha, no formato
+//     fonte endereço saída
+//   linhas vazias ou iniciadas por '#' são ignoradas; o manifesto "-" é lido
+//   da entrada padrão
+// os programas são distribuídos entre n threads (opção -j), cada montagem
+//   com o seu próprio contexto; as mensagens de erro são precedidas pelo
+//   nome do arquivo fonte
+
+typedef struct {
+  char *fonte;
+  int end;
+  char *saida;
+} tarefa_t;
+
+tarefa_t *tarefas = NULL;
+int n_tarefas;
+int cap_tarefas;
+atomic_int proxima_tarefa;  // próxima tarefa a ser pega por uma thread
+atomic_int n_falhas;        // tarefas que não puderam ser montadas
+
+// lê as tarefas do manifesto
+void le_manifesto(char *nome)
+{
+  FILE *arq = (strcmp(nome, "-") == 0) ? stdin : fopen(nome, "r");
+  if (arq == NULL) {
+    fprintf(stderr, "ERRO: Não foi possível abrir o manifesto '%s'\n", nome);
+    exit(1);
+  }
+  int nlinha = 0;
+  char *linha = NULL;
+  size_t nbytes;
+  while (getline(&linha, &nbytes, arq) != -1) {
+    nlinha++;
+    char *fonte = strtok(linha, " \t\r\n");
+    if (fonte == NULL || fonte[0] == '#') continue;
+    char *end = strtok(NULL, " \t\r\n");
+    char *saida = strtok(NULL, " \t\r\n");
+    char *fim = "";
+    int endn = (end == NULL) ? 0 : strtol(end, &fim, 0);
+    if (saida == NULL || *fim != '\0' || strtok(NULL, " \t\r\n") != NULL) {
+      fprintf(stderr, "ERRO: manifesto '%s', linha %d: esperado 'fonte endereço saída'\n",
+              nome, nlinha);
+      exit(1);
+    }
+    tarefas = vetor_cresce(tarefas, &cap_tarefas, n_tarefas + 1, sizeof(tarefa_t));
+    tarefas[n_tarefas].fonte = strdup(fonte);
+    tarefas[n_tarefas].end = endn;
+    tarefas[n_tarefas].saida = strdup(saida);
+    if (tarefas[n_tarefas].fonte == NULL || tarefas[n_tarefas].saida == NULL) {
+      erro_brabo("falta de memória no montador");
+    }
+    n_tarefas++;
+  }
+  free(linha);
+  if (arq != stdin) fclose(arq);
+}
+
+// monta tarefas até não ter mais nenhuma
+void *monta_tarefas(void *arg)
+{
+  (void)arg;
+  for (;;) {
+    int i = atomic_fetch_add(&proxima_tarefa, 1);
+    if (i >= n_tarefas) break;
+    if (!monta_programa(tarefas[i].fonte, tarefas[i].end, tarefas[i].saida, true)) {
+      atomic_fetch_add(&n_falhas, 1);
+    }
+  }
+  return NULL;
+}
+
+// monta todos os programas do manifesto, com 'n_threads' threads
+// retorna o número de programas que não puderam ser montados
+int monta_lote(char *manifesto, int n_threads)
+{
+  le_manifesto(manifesto);
+  atomic_init(&proxima_tarefa, 0);
+  atomic_init(&n_falhas, 0);
+  if (n_threads > n_tarefas) n_threads = n_tarefas;
+  if (n_threads <= 1) {
+    monta_tarefas(NULL);
+  } else {
+    pthread_t threads[n_threads];
+    for (int i = 0; i < n_threads; i++) {
+      if (pthread_create(&threads[i], NULL, monta_tarefas, NULL) != 0) {
+        erro_brabo("não foi possível criar as threads do montador");
+      }
+    }
+    for (int i = 0; i < n_threads; i++) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+  for (int i = 0; i < n_tarefas; i++) {
+    free(tarefas[i].fonte);
+    free(tarefas[i].saida);
+  }
+  free(tarefas);
+  return atomic_load(&n_falhas);
 }
 
 
@@ -393,28 +712,55 @@ void monta_arquivo(char *nome)
 // MAIN {{{1
 // ---------------------------------------------------------------------
 
+char *nome_fonte;       // nome do arquivo fonte a montar
+int end_inicial = 0;    // endereço de carga do programa
+char *nome_manifesto;   // nome do manifesto, para montagem em lote
+int n_threads = 1;      // threads da montagem em lote
+
+// converte o argumento de uma opção numérica, ou aborta
+int arg_numerico(int argc, char *argv[argc], int argi, char *opcao)
+{
+  if (argi >= argc) {
+    fprintf(stderr, "ERRO: falta valor após '%s'\n", opcao);
+    exit(1);
+  }
+  char *fim = argv[argi];
+  int valor = strtol(fim, &fim, 0);
+  if (*fim != '\0') {
+    fprintf(stderr, "ERRO: valor inválido para '%s': '%s'\n", opcao, argv[argi]);
+    exit(1);
+  }
+  return valor;
+}
+
 void verifica_args(int argc, char *argv[argc])
 {
   for (int argi = 1; argi < argc; argi++) {
     if (strcmp(argv[argi], "-e") == 0) {
+      argi++;
+      end_inicial = arg_numerico(argc, argv, argi, "-e");
+    } else if (strcmp(argv[argi], "-j") == 0) {
+      argi++;
+      n_threads = arg_numerico(argc, argv, argi, "-j");
+    } else if (strcmp(argv[argi], "-m") == 0) {
       argi++;
       if (argi >= argc) {
-        fprintf(stderr, "ERRO: falta endereço após '-e'\n");
-        exit(1);
-      }
-      char *fim = argv[argi];
-      mem_pos = strtol(fim, &fim, 0);
-      if (*fim != '\0') {
-        fprintf(stderr, "ERRO: endereço inválido: '%s'\n", argv[argi]);
+        fprintf(stderr, "ERRO: falta o manifesto após '-m'\n");
         exit(1);
       }
+      nome_manifesto = argv[argi];
+    } else if (strcmp(argv[argi], "-b") == 0) {
+      saida_binaria = true;
+    } else if (strcmp(argv[argi], "-s") == 0) {
+      gera_simbolos = true;
     } else {
       nome_fonte = argv[argi];
     }
   }
-  if (nome_fonte == NULL) {
-    fprintf(stderr, "ERRO: chame como '%s [-e end.inicial] nome_do_arquivo'\n",
-            argv[0]);
+  if ((nome_fonte == NULL) == (nome_manifesto == NULL)) {
+    fprintf(stderr, "ERRO: chame como '%s [-b] [-s] [-e end.inicial] nome_do_arquivo'\n"
+                    "          ou como '%s [-b] [-s] [-j n_threads] -m manifesto'\n",
+            argv[0], argv[0]);
     exit(1);
   }
 }
@@ -422,9 +768,10 @@ void verifica_args(int argc, char *argv[argc])
 int main(int argc, char *argv[argc])
 {
   verifica_args(argc, argv);
-  monta_arquivo(nome_fonte);
-  mem_imprime();
-  return 0;
+  if (nome_manifesto != NULL) {
+    return monta_lote(nome_manifesto, n_threads) == 0 ? 0 : 1;
+  }
+  return monta_programa(nome_fonte, end_inicial, NULL, false) ? 0 : 1;
 }
 
 // vim: foldmethod=marker
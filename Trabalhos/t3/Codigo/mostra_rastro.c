@@ -0,0 +1,179 @@
+// mostra_rastro.c
+// converte o rastro de eventos do SO em texto ou no formato do Chrome
+// simulador de computador
+// so25b
+
+// uso:
+//   ./mostra_rastro [-j] [arquivo]
+// lê o arquivo gravado pelo SO (ver rastro.h; o padrão é "rastro") e
+//   imprime na saída padrão
+//   - sem -j, uma linha por evento, com a data, o pid e os argumentos
+//   - com -j, um rastro no formato JSON do Chrome (trace event format), para
+//     abrir em chrome://tracing ou https://ui.perfetto.dev; cada processo é
+//     uma linha do tempo, com faixas para os intervalos em que esteve na CPU
+//     e marcas para os outros eventos; o tempo é o relógio do simulador, uma
+//     instrução por microssegundo
+
+#include "rastro.h"
+#include "irq.h"
+#include "so.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define MAX_PID 1000
+
+static char *nome_chamada(int id)
+{
+  switch (id) {
+    case SO_LE:          return "le";
+    case SO_LE_LINHA:    return "le_linha";
+    case SO_ESCR:        return "escr";
+    case SO_ESCR_STR:    return "escr_str";
+    case SO_CRIA_PROC:   return "cria_proc";
+    case SO_MATA_PROC:   return "mata_proc";
+    case SO_ESPERA_PROC: return "espera_proc";
+    case SO_DORME:       return "dorme";
+    default:             return "?";
+  }
+}
+
+// coloca em 'txt' a descrição dos argumentos do evento 'r'
+static void descreve_args(rastro_reg_t *r, char *txt, int tam)
+{
+  switch (r->evento) {
+    case RASTRO_IRQ:
+      snprintf(txt, tam, "%s PC=%d", irq_nome(r->a1), r->a2);
+      break;
+    case RASTRO_DESPACHA:
+      if (r->pid == 0) snprintf(txt, tam, "CPU parada");
+      else snprintf(txt, tam, "PC=%d", r->a1);
+      break;
+    case RASTRO_BLOQUEIA:
+      if (r->a1 == RASTRO_ESPERA_DATA) snprintf(txt, tam, "até %d", r->a2);
+      else if (r->a1 == RASTRO_ESPERA_PROC) snprintf(txt, tam, "espera o processo %d", r->a2);
+      else snprintf(txt, tam, "dispositivo %d", r->a1);
+      break;
+    case RASTRO_FALTA_PAGINA:
+      snprintf(txt, tam, "endereço %d página %d", r->a1, r->a2);
+      break;
+    case RASTRO_SUBSTITUI:
+      snprintf(txt, tam, "quadro %d página %d", r->a1, r->a2);
+      break;
+    case RASTRO_CHAMADA:
+      snprintf(txt, tam, "%s X=%d", nome_chamada(r->a1), r->a2);
+      break;
+    case RASTRO_CRIA:
+      snprintf(txt, tam, "carregado em %d", r->a1);
+      break;
+    default:
+      txt[0] = '\0';
+  }
+}
+
+static void mostra_texto(rastro_reg_t *regs, int n)
+{
+  for (int i = 0; i < n; i++) {
+    char args[100];
+    descreve_args(&regs[i], args, sizeof(args));
+    printf("%10d %-13s %4d %s\n", regs[i].data, rastro_nome_evento(regs[i].evento),
+           regs[i].pid, args);
+  }
+}
+
+static void mostra_json(rastro_reg_t *regs, int n)
+{
+  // pid que está na CPU (0 se nenhum), para fechar a faixa na interrupção
+  int na_cpu = 0;
+  bool visto[MAX_PID + 1] = { false };
+  bool primeiro = true;
+
+  printf("{\"traceEvents\":[\n");
+  for (int i = 0; i < n; i++) {
+    rastro_reg_t *r = &regs[i];
+    char args[100];
+    descreve_args(r, args, sizeof(args));
+    // nome da linha do tempo de cada processo, na primeira vez que aparece
+    if (r->pid > 0 && r->pid <= MAX_PID && !visto[r->pid]) {
+      visto[r->pid] = true;
+      printf("%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+             "\"args\":{\"name\":\"processo %d\"}}", primeiro ? "" : ",\n", r->pid, r->pid);
+      primeiro = false;
+    }
+    if (r->evento == RASTRO_IRQ && na_cpu != 0) {
+      printf("%s{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%d}",
+             primeiro ? "" : ",\n", na_cpu, r->data);
+      na_cpu = 0;
+      primeiro = false;
+    }
+    if (r->evento == RASTRO_DESPACHA) {
+      if (r->pid != 0) {
+        printf("%s{\"ph\":\"B\",\"pid\":1,\"tid\":%d,\"ts\":%d,\"name\":\"executa\","
+               "\"args\":{\"PC\":%d}}", primeiro ? "" : ",\n", r->pid, r->data, r->a1);
+        na_cpu = r->pid;
+        primeiro = false;
+      }
+      continue;
+    }
+    // os outros eventos são marcas instantâneas; os sem processo ficam na
+    //   linha do tempo 0
+    printf("%s{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%d,"
+           "\"name\":\"%s\",\"args\":{\"desc\":\"%s\"}}", primeiro ? "" : ",\n",
+           r->pid, r->data, rastro_nome_evento(r->evento), args);
+    primeiro = false;
+  }
+  if (na_cpu != 0 && n > 0) {
+    printf("%s{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%d}",
+           primeiro ? "" : ",\n", na_cpu, regs[n - 1].data);
+  }
+  printf("\n]}\n");
+}
+
+int main(int argc, char *argv[])
+{
+  bool json = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "j")) != -1) {
+    switch (opt) {
+      case 'j': json = true; break;
+      default:
+        fprintf(stderr, "uso: %s [-j] [arquivo]\n", argv[0]);
+        exit(1);
+    }
+  }
+  char *nome = (optind < argc) ? argv[optind] : "rastro";
+
+  FILE *f = fopen(nome, "rb");
+  if (f == NULL) {
+    perror(nome);
+    exit(1);
+  }
+  rastro_cabecalho_t cab;
+  if (fread(&cab, sizeof(cab), 1, f) != 1
+      || memcmp(cab.magica, RASTRO_MAGICA, sizeof(RASTRO_MAGICA)) != 0) {
+    fprintf(stderr, "%s: não é um arquivo de rastro\n", nome);
+    exit(1);
+  }
+  rastro_reg_t *regs = malloc(cab.n_registros * sizeof(*regs) + 1);
+  assert(regs != NULL);
+  if (fread(regs, sizeof(*regs), cab.n_registros, f) != cab.n_registros) {
+    fprintf(stderr, "%s: arquivo incompleto\n", nome);
+    exit(1);
+  }
+  fclose(f);
+
+  if (cab.n_perdidos > 0) {
+    fprintf(stderr, "%u eventos mais antigos foram perdidos (buffer cheio)\n", cab.n_perdidos);
+  }
+  if (json) {
+    mostra_json(regs, cab.n_registros);
+  } else {
+    mostra_texto(regs, cab.n_registros);
+  }
+  free(regs);
+  return 0;
+}
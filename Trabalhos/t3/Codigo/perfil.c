@@ -0,0 +1,109 @@
+// perfil.c
+// perfil de execução por amostragem, em pilhas "dobradas"
+// simulador de computador
+// so25b
+
+#include "perfil.h"
+#include "indice.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// uma pilha e o seu número de amostras
+typedef struct {
+  char *pilha;
+  long n;
+} pilha_t;
+
+// o mapa de símbolos de um programa (NULL se não existir)
+typedef struct {
+  char *programa;
+  simbolos_t *simbolos;
+} mapa_t;
+
+struct perfil_t {
+  // pilhas, encontradas pelo índice, que contém posições em pilhas
+  pilha_t *pilhas;
+  int n_pilhas;
+  int cap_pilhas;
+  indice_t *indice;
+  // mapas de símbolos já lidos
+  mapa_t *mapas;
+  int n_mapas;
+  int cap_mapas;
+};
+
+perfil_t *perfil_cria(void)
+{
+  perfil_t *self = calloc(1, sizeof(*self));
+  assert(self != NULL);
+  self->indice = indice_cria();
+  return self;
+}
+
+void perfil_destroi(perfil_t *self)
+{
+  for (int i = 0; i < self->n_pilhas; i++) free(self->pilhas[i].pilha);
+  free(self->pilhas);
+  indice_destroi(self->indice);
+  for (int i = 0; i < self->n_mapas; i++) {
+    free(self->mapas[i].programa);
+    if (self->mapas[i].simbolos != NULL) simbolos_destroi(self->mapas[i].simbolos);
+  }
+  free(self->mapas);
+  free(self);
+}
+
+void perfil_conta(perfil_t *self, char *pilha)
+{
+  int pos = indice_busca(self->indice, pilha);
+  if (pos != -1) {
+    self->pilhas[pos].n++;
+    return;
+  }
+  self->pilhas = vetor_cresce(self->pilhas, &self->cap_pilhas, self->n_pilhas + 1,
+                              sizeof(pilha_t));
+  pilha_t *p = &self->pilhas[self->n_pilhas];
+  p->pilha = strdup(pilha);
+  assert(p->pilha != NULL);
+  p->n = 1;
+  indice_insere(self->indice, p->pilha, self->n_pilhas++);
+}
+
+static int compara_pilhas(const void *a, const void *b)
+{
+  const pilha_t *pa = a, *pb = b;
+  return strcmp(pa->pilha, pb->pilha);
+}
+
+bool perfil_grava(perfil_t *self, char *nome)
+{
+  FILE *f = fopen(nome, "w");
+  if (f == NULL) return false;
+  // a ordenação muda as posições das pilhas, que são refeitas no índice
+  qsort(self->pilhas, self->n_pilhas, sizeof(pilha_t), compara_pilhas);
+  indice_limpa(self->indice);
+  for (int i = 0; i < self->n_pilhas; i++) {
+    indice_insere(self->indice, self->pilhas[i].pilha, i);
+  }
+  for (int i = 0; i < self->n_pilhas; i++) {
+    fprintf(f, "%s %ld\n", self->pilhas[i].pilha, self->pilhas[i].n);
+  }
+  return fclose(f) == 0;
+}
+
+simbolos_t *perfil_simbolos(perfil_t *self, char *programa)
+{
+  for (int i = 0; i < self->n_mapas; i++) {
+    if (strcmp(self->mapas[i].programa, programa) == 0) return self->mapas[i].simbolos;
+  }
+  self->mapas = vetor_cresce(self->mapas, &self->cap_mapas, self->n_mapas + 1,
+                             sizeof(mapa_t));
+  mapa_t *m = &self->mapas[self->n_mapas++];
+  m->programa = strdup(programa);
+  assert(m->programa != NULL);
+  m->simbolos = simbolos_le(programa);
+  return m->simbolos;
+}
@@ -0,0 +1,41 @@
+// perfil.h
+// perfil de execução por amostragem, em pilhas "dobradas"
+// simulador de computador
+// so25b
+
+#ifndef PERFIL_H
+#define PERFIL_H
+
+// o SO amostra a execução a cada tantas instruções (opção perfil=, ver
+//   config.h e cpu_define_amostragem) e conta cada amostra aqui, como uma
+//   pilha de chamadas em uma linha de texto, com os nomes das subrotinas
+//   separados por ';', da mais externa para a mais interna, por exemplo
+//     p1.maq[2];main;principal;impnum
+// no fim, as pilhas são gravadas em um arquivo, uma por linha, seguidas do
+//   número de amostras ("folded stacks"), que é o formato lido pelas
+//   ferramentas de flame graph (flamegraph.pl, speedscope, inferno)
+//
+// o perfil também guarda os mapas de símbolos dos programas (ver
+//   simbolos.h), lidos uma vez só para cada programa
+
+#include "simbolos.h"
+
+#include <stdbool.h>
+
+typedef struct perfil_t perfil_t;
+
+perfil_t *perfil_cria(void);
+
+void perfil_destroi(perfil_t *self);
+
+// conta uma amostra da pilha 'pilha'
+void perfil_conta(perfil_t *self, char *pilha);
+
+// grava as pilhas no arquivo 'nome', em ordem alfabética
+// retorna false em caso de erro
+bool perfil_grava(perfil_t *self, char *nome);
+
+// retorna o mapa de símbolos do programa 'programa', ou NULL se não tiver
+simbolos_t *perfil_simbolos(perfil_t *self, char *programa);
+
+#endif // PERFIL_H
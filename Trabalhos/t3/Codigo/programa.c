@@ -7,13 +7,34 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 struct programa_t {
   int carga;
   int tamanho;
+  int inicio;
+  // formato texto: os dados lidos do arquivo
   int *dados;
+  // formato binário: o mapeamento do arquivo e as palavras presentes nele
+  void *mapa;
+  size_t tam_mapa;
+  const int32_t *palavras;
+  int n_palavras;
 };
 
+// converte uma palavra do arquivo binário (little-endian) para int
+static int palavra_do_arquivo(int32_t p)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return (int32_t)__builtin_bswap32(p);
+#else
+  return p;
+#endif
+}
+
 // lê os dados do cabeçalho do arquivo (1ª linha)
 // tem "MAQ" seguido do tamanho e endereço inicial do programa
 static programa_t *pega_cabecalho(char *lin)
@@ -29,6 +50,8 @@ static programa_t *pega_cabecalho(char *lin)
   }
   prog->tamanho = tam;
   prog->carga = carga;
+  prog->inicio = carga;
+  prog->mapa = NULL;
   return prog;
 }
 
@@ -50,9 +73,56 @@ static void pega_dados(programa_t *self, char *lin)
   }
 }
 
+// tenta mapear o arquivo aberto em 'fd' como um programa no formato binário
+// retorna NULL se o arquivo não estiver nesse formato (ou se estiver
+//   inconsistente)
+static programa_t *mapeia_binario(int fd)
+{
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < sizeof(prog_cabecalho_t)) return NULL;
+  void *mapa = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapa == MAP_FAILED) return NULL;
+
+  const prog_cabecalho_t *cab = mapa;
+  int tamanho = palavra_do_arquivo(cab->tamanho);
+  int n_zeros = palavra_do_arquivo(cab->n_zeros);
+  int n_palavras = tamanho - n_zeros;
+  size_t tam_esperado = sizeof(*cab) + (size_t)n_palavras * sizeof(int32_t);
+  if (palavra_do_arquivo(cab->magico) != PROG_MAGICO
+      || tamanho < 0 || n_zeros < 0 || n_palavras < 0
+      || st.st_size < tam_esperado) {
+    munmap(mapa, st.st_size);
+    return NULL;
+  }
+
+  programa_t *prog = malloc(sizeof(*prog));
+  if (prog == NULL) {
+    munmap(mapa, st.st_size);
+    return NULL;
+  }
+  prog->carga = palavra_do_arquivo(cab->carga);
+  prog->tamanho = tamanho;
+  prog->inicio = palavra_do_arquivo(cab->inicio);
+  prog->dados = NULL;
+  prog->mapa = mapa;
+  prog->tam_mapa = st.st_size;
+  prog->palavras = (const int32_t *)(cab + 1);
+  prog->n_palavras = n_palavras;
+  return prog;
+}
+
 programa_t *prog_cria(char *nome)
 {
   programa_t *prog = NULL;
+
+  // tenta primeiro o formato binário, que não precisa ser interpretado
+  int fd = open(nome, O_RDONLY);
+  if (fd < 0) return NULL;
+  prog = mapeia_binario(fd);
+  close(fd);
+  if (prog != NULL) return prog;
+
+  // senão, lê o formato texto
   FILE *arq = fopen(nome, "r");
   if (arq == NULL) return NULL;
 
@@ -75,6 +145,7 @@ fim:
 
 void prog_destroi(programa_t *self)
 {
+  if (self->mapa != NULL) munmap(self->mapa, self->tam_mapa);
   free(self->dados);
   free(self);
 }
@@ -91,11 +162,16 @@ int prog_end_carga(programa_t *self)
 
 int prog_end_inicio(programa_t *self)
 {
-  return self->carga;
+  return self->inicio;
 }
 
 int prog_dado(programa_t *self, int ender)
 {
   if (ender < self->carga || ender >= self->carga + self->tamanho) return -1;
-  return self->dados[ender - self->carga];
+  int pos = ender - self->carga;
+  if (self->mapa != NULL) {
+    if (pos >= self->n_palavras) return 0;
+    return palavra_do_arquivo(self->palavras[pos]);
+  }
+  return self->dados[pos];
 }
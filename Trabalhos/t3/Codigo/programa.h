@@ -7,9 +7,32 @@
 #define PROGRAMA_H
 
 // TAD para representar um programa lido de um arquivo '.maq'
+//
+// o arquivo pode estar em dois formatos:
+// - texto: uma linha "//MAQ tamanho carga" seguida de linhas
+//   "[endereço] = dado, dado, ...,"
+// - binário (gerado pelo montador com a opção -b): um cabeçalho
+//   prog_cabecalho_t seguido das palavras do programa, cada uma com 4 bytes
+//   em little-endian. As últimas n_zeros palavras do programa valem 0 e não
+//   estão no arquivo. O arquivo binário é mapeado em memória (mmap), e os
+//   dados são lidos diretamente do mapeamento.
+
+#include <stdint.h>
 
 typedef struct programa_t programa_t;
 
+// identificação do formato binário ("MAQB" nos 4 primeiros bytes)
+#define PROG_MAGICO 0x4251414d
+
+// cabeçalho do formato binário, todos os campos em little-endian
+typedef struct {
+  int32_t magico;   // PROG_MAGICO
+  int32_t carga;    // endereço de carga
+  int32_t tamanho;  // número de palavras do programa, incluindo os zeros
+  int32_t inicio;   // endereço inicial de execução
+  int32_t n_zeros;  // número de palavras 0 no final, que não estão no arquivo
+} prog_cabecalho_t;
+
 // cria e inicializa um programa com o conteúdo do arquivo 'nome'
 // retorna NULL em caso de erro
 programa_t *prog_cria(char *nome);
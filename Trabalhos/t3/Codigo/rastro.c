@@ -0,0 +1,70 @@
+// rastro.c
+// rastro de eventos do SO, em formato binário
+// simulador de computador
+// so25b
+
+#include "rastro.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TAM_NOME_ARQUIVO 200
+
+rastro_reg_t rastro_buf[RASTRO_TAM];
+uint32_t rastro_n = 0;
+
+static char nome_arquivo[TAM_NOME_ARQUIVO] = "rastro";
+
+static char *nomes[N_RASTRO] = {
+  [RASTRO_IRQ]          = "irq",
+  [RASTRO_DESPACHA]     = "despacha",
+  [RASTRO_BLOQUEIA]     = "bloqueia",
+  [RASTRO_DESBLOQUEIA]  = "desbloqueia",
+  [RASTRO_FALTA_PAGINA] = "falta_pagina",
+  [RASTRO_SUBSTITUI]    = "substitui",
+  [RASTRO_CHAMADA]      = "chamada",
+  [RASTRO_CRIA]         = "cria",
+  [RASTRO_TERMINA]      = "termina",
+};
+
+void rastro_inicializa(char *nome)
+{
+  rastro_n = 0;
+  snprintf(nome_arquivo, sizeof(nome_arquivo), "%s", nome);
+}
+
+bool rastro_grava(void)
+{
+  FILE *f = fopen(nome_arquivo, "wb");
+  if (f == NULL) return false;
+
+  // se o buffer deu a volta, o registro mais antigo é o da próxima posição
+  rastro_cabecalho_t cab;
+  memset(&cab, 0, sizeof(cab));
+  strcpy(cab.magica, RASTRO_MAGICA);
+  uint32_t ini = 0;
+  cab.n_registros = rastro_n;
+  if (rastro_n > RASTRO_TAM) {
+    cab.n_registros = RASTRO_TAM;
+    cab.n_perdidos = rastro_n - RASTRO_TAM;
+    ini = rastro_n & (RASTRO_TAM - 1);
+  }
+
+  bool ok = fwrite(&cab, sizeof(cab), 1, f) == 1;
+  uint32_t n_fim = cab.n_registros - ini;
+  if (ok && n_fim > 0) ok = fwrite(&rastro_buf[ini], sizeof(rastro_reg_t), n_fim, f) == n_fim;
+  if (ok && ini > 0) ok = fwrite(rastro_buf, sizeof(rastro_reg_t), ini, f) == ini;
+  if (fclose(f) != 0) ok = false;
+  return ok;
+}
+
+char *rastro_nome_arquivo(void)
+{
+  return nome_arquivo;
+}
+
+char *rastro_nome_evento(int evento)
+{
+  if (evento < 0 || evento >= N_RASTRO) return "?";
+  return nomes[evento];
+}
@@ -0,0 +1,98 @@
+// rastro.h
+// rastro de eventos do SO, em formato binário
+// simulador de computador
+// so25b
+
+#ifndef RASTRO_H
+#define RASTRO_H
+
+// o SO registra os seus eventos (interrupções, despachos, bloqueios, faltas
+//   de página etc) em um buffer circular de registros binários de tamanho
+//   fixo, alocado uma vez só; registrar um evento é preencher um registro,
+//   sem formatar texto nem alocar memória, para poder ficar ligado o tempo
+//   todo sem pesar no simulador (ao contrário de depura, que formata uma
+//   linha por mensagem)
+// quando o buffer enche, os eventos mais antigos são sobrescritos
+//
+// o buffer é gravado em arquivo (com os eventos em ordem) quando o SO
+//   termina, ou pelo comando 'T' da console; o programa mostra_rastro
+//   converte o arquivo em texto ou no formato de rastro do Chrome
+//   (chrome://tracing ou https://ui.perfetto.dev)
+//
+// formato do arquivo: um rastro_cabecalho_t seguido de n_registros
+//   rastro_reg_t, na representação da máquina que gravou
+
+#include "relogio.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// número de registros do buffer (tem que ser potência de 2)
+#define RASTRO_TAM (1 << 16)
+
+#define RASTRO_MAGICA "RASTRO1"
+
+// eventos, com o significado dos argumentos
+typedef enum {
+  RASTRO_IRQ,         // interrupção; a1: irq_t, a2: PC do processo interrompido
+  RASTRO_DESPACHA,    // processo colocado na CPU (pid 0 é CPU parada); a1: PC
+  RASTRO_BLOQUEIA,    // a1: dispositivo, ou RASTRO_ESPERA_DATA (a2 é a data
+                      //   de desbloqueio) ou RASTRO_ESPERA_PROC (a2 é o pid
+                      //   esperado)
+  RASTRO_DESBLOQUEIA, // processo volta para a fila de prontos
+  RASTRO_FALTA_PAGINA,// a1: endereço virtual, a2: página
+  RASTRO_SUBSTITUI,   // quadro liberado (pid é o dono); a1: quadro, a2: página
+  RASTRO_CHAMADA,     // chamada de sistema; a1: número da chamada, a2: reg X
+  RASTRO_CRIA,        // processo criado; a1: endereço de carga
+  RASTRO_TERMINA,     // processo terminado
+  N_RASTRO
+} rastro_evento_t;
+
+// valores de a1 em RASTRO_BLOQUEIA, quando não é espera por dispositivo
+#define RASTRO_ESPERA_DATA -1
+#define RASTRO_ESPERA_PROC -2
+
+// um evento (16 bytes)
+typedef struct {
+  int32_t data;       // relógio do simulador (instruções executadas)
+  int16_t evento;     // rastro_evento_t
+  int16_t pid;
+  int32_t a1;
+  int32_t a2;
+} rastro_reg_t;
+
+typedef struct {
+  char magica[8];          // RASTRO_MAGICA
+  uint32_t n_registros;    // registros no arquivo
+  uint32_t n_perdidos;     // registros sobrescritos antes da gravação
+} rastro_cabecalho_t;
+
+// o buffer; só deve ser acessado por rastro_registra
+extern rastro_reg_t rastro_buf[RASTRO_TAM];
+extern uint32_t rastro_n;
+
+// registra um evento
+static inline void rastro_registra(rastro_evento_t evento, int pid, int a1, int a2)
+{
+  rastro_reg_t *r = &rastro_buf[rastro_n++ & (RASTRO_TAM - 1)];
+  r->data = relogio_agora();
+  r->evento = evento;
+  r->pid = pid;
+  r->a1 = a1;
+  r->a2 = a2;
+}
+
+// esvazia o buffer e define o nome do arquivo onde ele será gravado
+void rastro_inicializa(char *nome_arquivo);
+
+// grava o buffer no arquivo (o buffer não é alterado)
+// retorna false em caso de erro
+bool rastro_grava(void);
+
+// retorna o nome do arquivo onde o buffer é gravado
+char *rastro_nome_arquivo(void);
+
+// retorna o nome de um evento
+char *rastro_nome_evento(int evento);
+
+#endif // RASTRO_H
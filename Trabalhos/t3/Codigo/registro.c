@@ -0,0 +1,133 @@
+// registro.c
+// escrita de linhas de registro (log) em arquivo, em outra thread
+// simulador de computador
+// so25b
+
+#include "registro.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <assert.h>
+
+// tamanho do buffer circular, em bytes
+#define TAM_BUFFER (1 << 20)
+// tempo que a thread escritora dorme quando não tem o que escrever (em ns)
+#define ESPERA_ESCRITORA 1000000
+
+struct registro_t {
+  int fd;
+  pthread_t escritora;
+  char *buf;
+  // total de bytes já colocados e já tirados do buffer desde o início; as
+  //   posições no buffer são esses valores módulo TAM_BUFFER
+  // 'inseridos' só é alterado por quem registra, 'escritos' só pela escritora
+  atomic_long inseridos;
+  atomic_long escritos;
+  atomic_bool fim;
+  long descartadas;
+};
+
+// escreve no arquivo os bytes entre 'escritos' e 'inseridos'
+// retorna false se não tinha nada a escrever
+static bool registro_esvazia(registro_t *self)
+{
+  long ini = atomic_load_explicit(&self->escritos, memory_order_relaxed);
+  long fim = atomic_load_explicit(&self->inseridos, memory_order_acquire);
+  if (fim == ini) return false;
+  while (ini < fim) {
+    // escreve até o fim dos dados ou do buffer, o que vier antes
+    int pos = ini % TAM_BUFFER;
+    long n = fim - ini;
+    if (n > TAM_BUFFER - pos) n = TAM_BUFFER - pos;
+    ssize_t r = write(self->fd, self->buf + pos, n);
+    if (r <= 0) break;  // erro de escrita: os dados são perdidos
+    ini += r;
+  }
+  atomic_store_explicit(&self->escritos, fim, memory_order_release);
+  return true;
+}
+
+static void *registro_escritora(void *arg)
+{
+  registro_t *self = arg;
+  struct timespec espera = { 0, ESPERA_ESCRITORA };
+  for (;;) {
+    // lê o fim antes de esvaziar, para não perder o que foi inserido antes
+    bool terminar = atomic_load_explicit(&self->fim, memory_order_acquire);
+    if (!registro_esvazia(self)) {
+      if (terminar) break;
+      nanosleep(&espera, NULL);
+    }
+  }
+  return NULL;
+}
+
+registro_t *registro_cria(char *nome)
+{
+  int fd = open(nome, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) return NULL;
+
+  registro_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->buf = malloc(TAM_BUFFER);
+  assert(self->buf != NULL);
+  self->fd = fd;
+  atomic_init(&self->inseridos, 0);
+  atomic_init(&self->escritos, 0);
+  atomic_init(&self->fim, false);
+  self->descartadas = 0;
+
+  int r = pthread_create(&self->escritora, NULL, registro_escritora, self);
+  assert(r == 0);
+  (void)r;
+
+  return self;
+}
+
+void registro_destroi(registro_t *self)
+{
+  atomic_store_explicit(&self->fim, true, memory_order_release);
+  pthread_join(self->escritora, NULL);
+  if (self->descartadas > 0) {
+    char msg[100];
+    int n = snprintf(msg, sizeof(msg), "registro: %ld linhas descartadas\n",
+                     self->descartadas);
+    if (write(self->fd, msg, n) != n) {
+      ; // não tem mais onde avisar
+    }
+  }
+  close(self->fd);
+  free(self->buf);
+  free(self);
+}
+
+bool registro_linha(registro_t *self, char *linha)
+{
+  long tam = strlen(linha) + 1;
+  long ini = atomic_load_explicit(&self->escritos, memory_order_acquire);
+  long fim = atomic_load_explicit(&self->inseridos, memory_order_relaxed);
+  if (TAM_BUFFER - (fim - ini) < tam) {
+    self->descartadas++;
+    return false;
+  }
+  // copia a linha, que pode dar a volta no final do buffer
+  int pos = fim % TAM_BUFFER;
+  long n1 = tam - 1;
+  if (n1 > TAM_BUFFER - pos) n1 = TAM_BUFFER - pos;
+  memcpy(self->buf + pos, linha, n1);
+  memcpy(self->buf, linha + n1, tam - 1 - n1);
+  self->buf[(fim + tam - 1) % TAM_BUFFER] = '\n';
+  atomic_store_explicit(&self->inseridos, fim + tam, memory_order_release);
+  return true;
+}
+
+long registro_descartadas(registro_t *self)
+{
+  return self->descartadas;
+}
@@ -0,0 +1,42 @@
+// registro.h
+// escrita de linhas de registro (log) em arquivo, em outra thread
+// simulador de computador
+// so25b
+
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+// mantém um arquivo de registro onde são escritas linhas de texto
+//
+// quem registra (uma só thread, o simulador) coloca as linhas em um buffer
+//   circular de tamanho fixo, sem esperar pelo disco; uma thread escritora
+//   tira do buffer tudo que tiver acumulado e escreve no arquivo com uma
+//   chamada a write por vez
+// o buffer não usa trava: só quem registra altera a posição de inserção, e
+//   só a thread escritora altera a posição de remoção
+// se o buffer estiver cheio, a linha é descartada e contada
+//
+// registro_destroi espera a escrita de tudo que está no buffer antes de
+//   fechar o arquivo
+
+#include <stdbool.h>
+
+typedef struct registro_t registro_t;
+
+// cria um registro que escreve no arquivo 'nome' (que é truncado)
+// retorna NULL se não for possível abrir o arquivo
+registro_t *registro_cria(char *nome);
+
+// escreve no arquivo tudo que estiver no buffer, termina a thread escritora
+//   e fecha o arquivo
+// se alguma linha tiver sido descartada, registra isso no final do arquivo
+void registro_destroi(registro_t *self);
+
+// coloca a linha 'linha' (mais um '\n') no buffer, para ser escrita no arquivo
+// retorna false se a linha foi descartada por falta de espaço
+bool registro_linha(registro_t *self, char *linha);
+
+// retorna o número de linhas descartadas até agora
+long registro_descartadas(registro_t *self);
+
+#endif // REGISTRO_H
@@ -0,0 +1,92 @@
+// simbolos.c
+// mapa de símbolos de um programa, gerado pelo montador
+// simulador de computador
+// so25b
+
+#include "simbolos.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+typedef struct {
+  int end;
+  int fim;    // -1 se não for subrotina
+  char *nome;
+} simbolo_t;
+
+struct simbolos_t {
+  simbolo_t *simb;   // em ordem de endereço
+  int n;
+};
+
+static int compara(const void *a, const void *b)
+{
+  const simbolo_t *sa = a, *sb = b;
+  return sa->end - sb->end;
+}
+
+simbolos_t *simbolos_le(char *programa)
+{
+  char nome[FILENAME_MAX];
+  char *ponto = strrchr(programa, '.');
+  int n_nome = (ponto != NULL && strchr(ponto, '/') == NULL) ? ponto - programa
+                                                             : (int)strlen(programa);
+  snprintf(nome, sizeof(nome), "%.*s.simb", n_nome, programa);
+  FILE *f = fopen(nome, "r");
+  if (f == NULL) return NULL;
+
+  simbolos_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->simb = NULL;
+  self->n = 0;
+  int cap = 0;
+  char linha[200], txt[200];
+  int end, fim;
+  while (fgets(linha, sizeof(linha), f) != NULL) {
+    if (linha[0] == '#' || sscanf(linha, "%d %d %199s", &end, &fim, txt) != 3) continue;
+    if (self->n == cap) {
+      cap = (cap == 0) ? 32 : 2 * cap;
+      self->simb = realloc(self->simb, cap * sizeof(simbolo_t));
+      assert(self->simb != NULL);
+    }
+    self->simb[self->n].end = end;
+    self->simb[self->n].fim = fim;
+    self->simb[self->n].nome = strdup(txt);
+    assert(self->simb[self->n].nome != NULL);
+    self->n++;
+  }
+  fclose(f);
+  qsort(self->simb, self->n, sizeof(simbolo_t), compara);
+  return self;
+}
+
+void simbolos_destroi(simbolos_t *self)
+{
+  for (int i = 0; i < self->n; i++) free(self->simb[i].nome);
+  free(self->simb);
+  free(self);
+}
+
+char *simbolos_nome(simbolos_t *self, int end)
+{
+  // busca binária pelo último símbolo com endereço <= end
+  int ini = 0, fim = self->n;
+  while (ini < fim) {
+    int meio = (ini + fim) / 2;
+    if (self->simb[meio].end <= end) ini = meio + 1;
+    else fim = meio;
+  }
+  return (ini == 0) ? NULL : self->simb[ini - 1].nome;
+}
+
+int simbolos_rotina(simbolos_t *self, int end)
+{
+  // a mais interna é a que começa mais perto de 'end'
+  for (int i = self->n - 1; i >= 0; i--) {
+    simbolo_t *s = &self->simb[i];
+    if (s->end <= end && end < s->fim) return s->end;
+  }
+  return -1;
+}
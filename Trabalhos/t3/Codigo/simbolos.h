@@ -0,0 +1,31 @@
+// simbolos.h
+// mapa de símbolos de um programa, gerado pelo montador
+// simulador de computador
+// so25b
+
+#ifndef SIMBOLOS_H
+#define SIMBOLOS_H
+
+// o montador, com a opção -s, gera para cada programa x.maq um arquivo
+//   x.simb com os labels do programa, os seus endereços e, para os labels
+//   de subrotinas, o fim da subrotina (ver montador.c)
+// uma subrotina começa no seu label, onde CHAMA coloca o endereço de
+//   retorno, e vai até depois da última instrução 'RET label'
+
+typedef struct simbolos_t simbolos_t;
+
+// lê o mapa de símbolos do programa 'programa' (o nome do .maq)
+// retorna NULL se o mapa não existir
+simbolos_t *simbolos_le(char *programa);
+
+void simbolos_destroi(simbolos_t *self);
+
+// retorna o nome do label com o maior endereço que não seja maior que
+//   'end', ou NULL se não tiver
+char *simbolos_nome(simbolos_t *self, int end);
+
+// retorna o endereço da subrotina mais interna que contém 'end' (que é onde
+//   está o seu endereço de retorno), ou -1 se não tiver
+int simbolos_rotina(simbolos_t *self, int end);
+
+#endif // SIMBOLOS_H
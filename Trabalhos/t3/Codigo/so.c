@@ -14,10 +14,18 @@
 #include "irq.h"
 #include "memoria.h"
 #include "programa.h"
+#include "imagens.h"
 #include "tabpag.h"
 #include "fila.h"
+#include "agenda.h"
 #include "metricas.h"
+#include "estat.h"
+#include "depura.h"
 #include "relogio.h"
+#include "config.h"
+#include "cronometro.h"
+#include "rastro.h"
+#include "perfil.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -29,25 +37,21 @@
 // CONSTANTES E TIPOS {{{1
 // ---------------------------------------------------------------------
 
-#define MEM_TAM 1000
-// tempo de transferência de uma página entre a memória principal e a secundária
-#define TEMPO_SWAP 0  // 0 por enquanto para testar
+// o tamanho das memórias, o tempo de transferência de uma página entre a
+//   memória principal e a secundária, o intervalo entre interrupções do
+//   relógio, o quantum e o escalonador estão na configuração (ver config.h)
 #define PROTEGIDO 100 // pid de uma página protegida
-
-// intervalo entre interrupções do relógio
-#define INTERVALO_INTERRUPCAO 50   // em instruções executadas
-// definidas no t2
-#define QUANTUM 10
+#define SEM_QUADRO -1  // página sem quadro na memória secundária
+#define SEM_DATA -1    // latência que não está sendo medida
 
 #define N_MAX_PROCESSOS 5 // num máx de processos
 #define N_TERMINAIS 4 
 #define SEM_PROCESSO -1  // não tem processo atual
 #define SEM_DISPOSITIVO -1  // não tem um dispositivo que causou bloqueio
-
-#define SEM_ESCALONADOR 0
-#define ROUND_ROBIN 1
-#define PRIORIDADE 2
-#define ESCALONADOR 1
+// tamanho do buffer de saída de cada terminal, em caracteres
+#define TAM_SAIDA 100
+// tamanho do buffer de entrada de cada terminal, em caracteres
+#define TAM_ENTRADA 100
 
 // Não tem processos nem memória virtual, mas é preciso usar a paginação,
 //   pelo menos para implementar relocação, já que os programas estão sendo
@@ -69,13 +73,57 @@ typedef enum estado_t {
   FINALIZADO
 } estado_t;
 
+// buffer circular com os caracteres a escrever na tela de um terminal
+typedef struct saida_t {
+  int buf[TAM_SAIDA];
+  int ini;  // posição do primeiro caractere
+  int n;    // número de caracteres no buffer
+} saida_t;
+
+// buffer circular com os caracteres lidos do teclado de um terminal que
+//   ainda não foram entregues a nenhum processo
+typedef struct entrada_t {
+  int buf[TAM_ENTRADA];
+  int ini;       // posição do primeiro caractere
+  int n;         // número de caracteres no buffer
+  int n_linhas;  // número de fins de linha no buffer
+} entrada_t;
+
 typedef struct quadro {
   int pid;
   int pagina;
 } quadro_t;
 
+// nome de cada chamada de sistema, para as estatísticas
+static char *nome_chamada[] = {
+  [SO_LE] = "le",
+  [SO_LE_LINHA] = "le_linha",
+  [SO_ESCR] = "escr",
+  [SO_ESCR_STR] = "escr_str",
+  [SO_CRIA_PROC] = "cria_proc",
+  [SO_MATA_PROC] = "mata_proc",
+  [SO_ESPERA_PROC] = "espera_proc",
+  [SO_DORME] = "dorme",
+};
+#define N_CHAMADAS (int)(sizeof(nome_chamada) / sizeof(nome_chamada[0]))
+
+// estatísticas (ver estat.h) atualizadas nos eventos do SO, do sistema todo
+//   ou de um processo; são obtidas uma vez só, na criação do SO ou do
+//   processo, para não formatar o nome e procurar na tabela a cada evento
+// as de cada chamada de sistema são obtidas no primeiro uso da chamada (são
+//   NULL antes), para não criar estatísticas vazias
+typedef struct {
+  estat_t *faltas_pagina;
+  estat_t *paginas_carregadas;
+  estat_t *paginas_gravadas;
+  estat_t *latencia_falta_pagina;
+  estat_t *chamadas[N_CHAMADAS];
+  estat_t *latencia_chamada[N_CHAMADAS];
+} estat_eventos_t;
+
 typedef struct processo_t {
   int pid; // id do processo
+  int num; // número do processo, na ordem de criação (nomes das estatísticas)
   int regPC; // end da próxima instrução executar
   int regA; // tipo de interrupção
   int regX; 
@@ -86,6 +134,7 @@ typedef struct processo_t {
 
   int pid_esperado; // pid do processo que este processo ta esperando morrer
   int dispositivo_causou_bloqueio; // id do dispositivo que causou o bloqueio (para SO_LE e SO_ESCR)
+  int end_escrita; // próximo endereço da string de SO_ESCR_STR a copiar
 
   int quantum;
   float prioridade;
@@ -93,8 +142,23 @@ typedef struct processo_t {
   // T3
   tabpag_t *tabpag;
   int regComplemento; 
-  int quadro_mem2;  // quadro a partir do qual o programa foi carregado em memória secundária
+  // imagem do programa (do cache de imagens), de onde vêm as páginas que
+  //   nunca foram alteradas
+  programa_t *imagem;
+  int tam_mem_virt; // tamanho da memória virtual do processo, em palavras
+  // quadro da memória secundária de cada página, ou SEM_QUADRO se a página
+  //   nunca foi alterada fora da memória principal (está só na imagem)
+  int *quadro_mem2;
   int data_desbloqueio;  // data até desbloquear um processo
+
+  // datas para as latências, SEM_DATA se não estiver medindo (a espera na
+  //   fila de prontos é medida em metricas, como tempo de resposta)
+  int data_falta_pagina;  // falta de página, até poder executar de novo
+  int data_chamada;       // chamada de sistema 'id_chamada', até terminar
+  int id_chamada;
+
+  // estatísticas do processo
+  estat_eventos_t estat;
 } processo_t;
 
 // t3: a interface de algumas funções que manipulam memória teve que ser alterada,
@@ -117,6 +181,7 @@ struct so_t {
   mmu_t *mmu;
   es_t *es;
   console_t *console;
+  config_t config;
   bool erro_interno;
 
   //int regA, regX, regPC, regERRO, regComplemento; // cópia do estado da CPU
@@ -127,8 +192,21 @@ struct so_t {
   processo_t *processo_atual;
   int n_processos_tabela;
   Fila *processos_prontos;
+  // true se o estado da CPU na memória é o de um processo (o SO despachou um
+  //   processo na última interrupção); false se a CPU está parada
+  bool cpu_com_processo;
   // id dos processos que estão usando cada terminal
   int terminais_usados[N_TERMINAIS];
+  // filas de espera por dispositivo: pids dos processos bloqueados esperando
+  //   o teclado ou a tela de cada terminal, em ordem de chegada
+  Fila *espera_teclado[N_TERMINAIS];
+  Fila *espera_tela[N_TERMINAIS];
+  // caracteres já aceitos pelo SO que ainda não foram escritos na tela de
+  //   cada terminal, na ordem em que foram pedidos
+  saida_t saida[N_TERMINAIS];
+  // caracteres já lidos do teclado de cada terminal que ainda não foram
+  //   entregues a nenhum processo
+  entrada_t entrada[N_TERMINAIS];
 
   // primeiro quadro da memória que está livre (quadros anteriores estão ocupados)
   // t3: com memória virtual, o controle de memória livre e ocupada deve ser mais
@@ -136,6 +214,12 @@ struct so_t {
   int quadro_livre_mem;
   // vetor de quadros com o pid do dono do quadro e o número da página que o ocupa
   quadro_t *tabquadros;
+  int n_quadros;
+  // tamanho das páginas (e dos quadros), definido pela MMU
+  int tam_pagina;
+  // próximo quadro a examinar na escolha do quadro a liberar quando a memória
+  //   está cheia (algoritmo do relógio)
+  int ponteiro_relogio;
 
   // memória secundaria
   mem_t *mem2;
@@ -143,13 +227,36 @@ struct so_t {
   bool mem2_livre;
   // tempo até liberar a memória secundária
   int mem2_tempo_ate_livre;
-  // primeiro quadro da memória secundária que está livre
-  int quadro_livre_mem2;
+  // vetor de quadros da memória secundária, com o pid do dono e a página
+  //   guardada; só as páginas alteradas têm um quadro na memória secundária
+  quadro_t *tabquadros_mem2;
+  int n_quadros_mem2;
+
+  // processos bloqueados até uma data (swap, SO_DORME), ordenados pela data
+  agenda_t *desbloqueios;
+
+  // programas já lidos, para não ler de novo o arquivo a cada criação
+  imagens_t *imagens;
+
+  // data da próxima amostra das estatísticas
+  int data_proxima_amostra;
+  // estatísticas do sistema todo, as dos eventos e os medidores amostrados
+  estat_eventos_t estat;
+  estat_t *estat_quadros_liberados;
+  estat_t *estat_quadros_ocupados;
+  estat_t *estat_quadros_mem2_ocupados;
+  estat_t *estat_prontos;
+  estat_t *estat_bloqueados;
+
+  // perfil de execução por amostragem (NULL se desligado)
+  perfil_t *perfil;
 };
 
 
 // função de tratamento de interrupção (entrada no SO)
 static int so_trata_interrupcao(void *argC, int reg_A);
+// função de amostragem da execução, chamada pela CPU (ver PERFIL)
+static void so_amostra_perfil(void *arg, int PC, cpu_modo_t modo, bool parada);
 
 // funções auxiliares
 // no t3, foi adicionado o 'processo' aos argumentos dessas funções 
@@ -160,20 +267,24 @@ static int so_carrega_programa(so_t *self, processo_t *processo,
 // copia para str da memória do processo, até copiar um 0 (retorna true) ou tam bytes
 static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
                                      int end_virt, processo_t processo);
+// lê um valor da memória virtual do processo
+static err_t so_le_mem_processo(so_t *self, processo_t *proc, int end_virt,
+                                int *pvalor);
+// escreve um valor na memória virtual do processo
+static err_t so_escreve_mem_processo(so_t *self, processo_t *proc, int end_virt,
+                                     int valor);
 
 // função para encontrar um quadro livre na memória principal
 static int acha_quadro_livre(so_t *self) {
-    int total_quadros = MEM_TAM / TAM_PAGINA;
-    
     // Procura por um quadro livre na tabela de quadros
-    for (int i = 0; i < total_quadros; i++) {
+    for (int i = 0; i < self->n_quadros; i++) {
         if (self->tabquadros[i].pid == SEM_PROCESSO) {
-            console_printf("DEBUG: Quadro livre encontrado: %d", i);
+            depura(DEP_MEM, NIVEL_DETALHE, "SO: quadro livre encontrado: %d", i);
             return i;
         }
     }
     
-    console_printf("DEBUG: Nenhum quadro livre encontrado");
+    depura(DEP_MEM, NIVEL_DETALHE, "SO: nenhum quadro livre encontrado");
     return -1; // Memória cheia
 }                                    
 // --------------- FUNÇÕES PROCESSOS ---------------
@@ -201,13 +312,28 @@ static bool associa_terminal_a_processo(so_t *so, processo_t *proc){
   return false;  // não tem um terminal disponível
 }
 
+// obtém as estatísticas do processo 'proc', que já tem o número
+static void processo_obtem_estat(processo_t *proc)
+{
+  int num = proc->num;
+  estat_eventos_t *e = &proc->estat;
+  e->faltas_pagina = estat_contador("proc.%d.faltas_pagina", num);
+  e->paginas_carregadas = estat_contador("proc.%d.paginas_carregadas", num);
+  e->paginas_gravadas = estat_contador("proc.%d.paginas_gravadas", num);
+  e->latencia_falta_pagina = estat_histograma("proc.%d.latencia.falta_pagina", num);
+  for (int i = 0; i < N_CHAMADAS; i++) {
+    e->chamadas[i] = NULL;
+    e->latencia_chamada[i] = NULL;
+  }
+}
+
 // t3: precisa criar tab de pag
 // cria um processo, retorna pid
 int processo_cria(so_t *so, char *nome_do_executavel, int *ender_carga)
 {
     // verifica se tem espaço disponível na tabela de processos
     if (so->n_processos_tabela >= N_MAX_PROCESSOS) {
-        console_printf("Limite de processos atingido.\n");
+        depura(DEP_PROC, NIVEL_AVISO, "Limite de processos atingido.\n");
         return -1;
     }
 
@@ -228,17 +354,20 @@ int processo_cria(so_t *so, char *nome_do_executavel, int *ender_carga)
       so->tabela_de_processos[i].estado = PRONTO;
       so->tabela_de_processos[i].dispositivo_causou_bloqueio = SEM_DISPOSITIVO;
       so->tabela_de_processos[i].pid_esperado = SEM_PROCESSO;
-      so->tabela_de_processos[i].quantum = QUANTUM;
+      so->tabela_de_processos[i].quantum = so->config.quantum;
       so->tabela_de_processos[i].prioridade = 0.5;
       so->tabela_de_processos[i].tabpag = tabpag_cria();  // cria tabpag importante
-      so->tabela_de_processos[i].quadro_mem2 = 0;
+      so->tabela_de_processos[i].imagem = NULL;
+      so->tabela_de_processos[i].quadro_mem2 = NULL;
+      so->tabela_de_processos[i].tam_mem_virt = 0;
       so->tabela_de_processos[i].data_desbloqueio = 0;
+      so->tabela_de_processos[i].data_falta_pagina = SEM_DATA;
+      so->tabela_de_processos[i].data_chamada = SEM_DATA;
       
       // métricas
-      metricas.processos_pid[slot] = slot + 1;
-      metricas.processos_estado[slot] = PRONTO;
-      metricas.n_prontos[slot]++;
-      metricas.processos_recem_criado[slot] = true;
+      so->tabela_de_processos[slot].num = metricas_processo_criado(slot + 1);
+      estat_define(estat_medidor("proc.%d.pid", so->tabela_de_processos[slot].num), slot + 1);
+      processo_obtem_estat(&so->tabela_de_processos[slot]);
       break;
     }
   }
@@ -255,7 +384,7 @@ int processo_cria(so_t *so, char *nome_do_executavel, int *ender_carga)
 
   // verifica se o endereço é válido
   if (endereco_inicial < 0) {
-    console_printf("SO: problema na carga de um programa");
+    depura(DEP_PROC, NIVEL_ERRO, "SO: problema na carga de um programa");
     so->erro_interno = true;
     return -1;
   }
@@ -263,35 +392,69 @@ int processo_cria(so_t *so, char *nome_do_executavel, int *ender_carga)
   // vê se tem um terminal disponível e associa ao processo
   if (!associa_terminal_a_processo(so, &so->tabela_de_processos[slot])){
     so->tabela_de_processos[slot].terminal = -1;
-    console_printf("TERMINAL NÃO ASSOCIADO");
+    depura(DEP_PROC, NIVEL_AVISO, "TERMINAL NÃO ASSOCIADO");
   }
 
   // insere na fila de processo prontos
   fila_enque(so->processos_prontos, so->tabela_de_processos[slot].pid);
+  rastro_registra(RASTRO_CRIA, slot + 1, endereco_inicial, 0);
 
   // imprime tabela para debugar
-  console_printf("Processo criado\n");
+  depura(DEP_PROC, NIVEL_INFO, "Processo criado\n");
 
   so->n_processos_tabela++;
   return so->tabela_de_processos[slot].pid;
 }
 
+static void processo_desbloqueia(so_t *self, processo_t *proc);
+
+// libera a memória de um processo que morreu: os quadros que ele ocupa na
+//   memória principal e na secundária, e a imagem do programa
+static void processo_libera_memoria(so_t *self, processo_t *proc)
+{
+  for (int q = 0; q < self->n_quadros; q++) {
+    if (self->tabquadros[q].pid == proc->pid) {
+      self->tabquadros[q].pid = SEM_PROCESSO;
+      self->tabquadros[q].pagina = -1;
+    }
+  }
+  for (int q = 0; q < self->n_quadros_mem2; q++) {
+    if (self->tabquadros_mem2[q].pid == proc->pid) {
+      self->tabquadros_mem2[q].pid = SEM_PROCESSO;
+      self->tabquadros_mem2[q].pagina = -1;
+    }
+  }
+  free(proc->quadro_mem2);
+  proc->quadro_mem2 = NULL;
+  if (proc->imagem != NULL) imagens_devolve(self->imagens, proc->imagem);
+  proc->imagem = NULL;
+}
+
 // mata um processo, liberando o slot e o terminal
 void processo_mata(so_t *self, int pid){
 
   // evita tentar excluir quando não há processos em execução
     if (self->n_processos_tabela <= 0) {
-        console_printf("Nenhum processo ativo para finalizar!\n");
+        depura(DEP_PROC, NIVEL_AVISO, "Nenhum processo ativo para finalizar!\n");
         return;
     }
 
   self->n_processos_tabela--;
 
+  // um processo morto não espera mais nenhum dispositivo nem a CPU (na fila
+  //   de prontos, ele pode estar em qualquer posição)
+  int pid_morto = (pid == 0) ? self->processo_atual->pid : pid;
+  rastro_registra(RASTRO_TERMINA, pid_morto, 0, 0);
+  for (int t = 0; t < N_TERMINAIS; t++) {
+    fila_remove(self->espera_teclado[t], pid_morto);
+    fila_remove(self->espera_tela[t], pid_morto);
+  }
+  fila_remove(self->processos_prontos, pid_morto);
+
   if (pid == 0){
     // mata o processo corrente
     self->processo_atual->estado = FINALIZADO;
-    int indice_finalizado = acha_indice_por_pid(self, self->processo_atual->pid);
-    metricas.processos_estado[indice_finalizado] = FINALIZADO;
+    metricas_muda_estado(self->processo_atual->num, FINALIZADO);
 
     for (int i = 0; i < N_TERMINAIS; i++) {
       // Verifica qual terminal tem o PID deste processo
@@ -301,6 +464,7 @@ void processo_mata(so_t *self, int pid){
       }
     }
     tabpag_destroi(self->processo_atual->tabpag);
+    processo_libera_memoria(self, self->processo_atual);
     
     self->processo_atual->pid = SEM_PROCESSO;
     self->processo_atual->terminal = -1;
@@ -310,8 +474,6 @@ void processo_mata(so_t *self, int pid){
         self->terminais_usados[i] = SEM_PROCESSO;
       }
     }*/
-    
-    fila_deque(self->processos_prontos);
   
   }else{
     // busca e encerra processo pelo PID fornecido
@@ -326,6 +488,8 @@ void processo_mata(so_t *self, int pid){
         }
 
         tabpag_destroi(self->tabela_de_processos[i].tabpag);
+        processo_libera_memoria(self, &self->tabela_de_processos[i]);
+        metricas_muda_estado(self->tabela_de_processos[i].num, FINALIZADO);
 
         self->tabela_de_processos[i].estado = FINALIZADO;
         self->tabela_de_processos[i].pid = SEM_PROCESSO;
@@ -344,13 +508,14 @@ void processo_mata(so_t *self, int pid){
   }
 
   // verifica se algum processo tava esperando pela finalização deste PID
+  // (o pid pode ter sido 0, o processo morto é pid_morto)
   for (int i = 0; i < N_MAX_PROCESSOS; i++) {
-    if (self->tabela_de_processos[i].pid_esperado == pid){
-      self->tabela_de_processos[i].estado = PRONTO;
-      // metricas
-      metricas.n_prontos[i]++;
-      // add processo na fila de prontos
-      fila_enque(self->processos_prontos, self->tabela_de_processos[i].pid);
+    processo_t *p = &self->tabela_de_processos[i];
+    if (p->pid != SEM_PROCESSO && p->estado == BLOQUEADO
+        && p->pid_esperado == pid_morto){
+      p->pid_esperado = SEM_PROCESSO;
+      p->regA = 0;
+      processo_desbloqueia(self, p);
     }
   }
 }
@@ -363,6 +528,27 @@ int acha_indice_por_pid(so_t *self, int pid){
   return SEM_PROCESSO;
 }
 
+// põe o processo 'proc' em execução, como processo corrente
+static void processo_executa(so_t *self, processo_t *proc)
+{
+  self->processo_atual = proc;
+  if (proc->estado == EXECUTANDO) return;
+  proc->estado = EXECUTANDO;
+  // métricas
+  metricas_muda_estado(proc->num, EXECUTANDO);
+}
+
+// tira de execução o processo 'proc', que continua pronto para executar (fim
+//   do quantum, ou outro processo escolhido pelo escalonador)
+// a posição dele na fila de prontos fica por conta de quem chama
+static void processo_preempta(processo_t *proc)
+{
+  proc->estado = PRONTO;
+  // métricas
+  metricas.n_preempcoes++;
+  metricas_muda_estado(proc->num, PRONTO);
+}
+
 void processo_troca_corrente(so_t *self){
   // acha o primeiro processo existente na tabela
   int i = 0;
@@ -370,8 +556,7 @@ void processo_troca_corrente(so_t *self){
   while (i < N_MAX_PROCESSOS){
 
     if (self->tabela_de_processos[i].pid != SEM_PROCESSO && self->tabela_de_processos[i].estado == PRONTO){
-      self->processo_atual = &self->tabela_de_processos[i];
-      self->processo_atual->estado = EXECUTANDO;
+      processo_executa(self, &self->tabela_de_processos[i]);
       break;
     }
 
@@ -396,9 +581,119 @@ static bool processo_existe(so_t *self, int pid){
 }
 
 // atualiza a prioridade de um processo
-static void processo_atualiza_prioridade(processo_t *proc){
+static void processo_atualiza_prioridade(so_t *self, processo_t *proc){
   // prioridade = (prioridade + t_execucao/t_quantum) / 2
-  proc->prioridade = (proc->prioridade + proc->quantum / QUANTUM) / 2;
+  proc->prioridade = (proc->prioridade + proc->quantum / self->config.quantum) / 2;
+}
+
+// bloqueia um processo até a data 'data' (em instruções executadas)
+// o desbloqueio é feito em so_trata_pendencias, quando a data chegar
+static void processo_bloqueia_ate(so_t *self, processo_t *proc, int data)
+{
+  proc->estado = BLOQUEADO;
+  proc->data_desbloqueio = data;
+  agenda_insere(self->desbloqueios, data, proc->pid);
+  rastro_registra(RASTRO_BLOQUEIA, proc->pid, RASTRO_ESPERA_DATA, data);
+  fila_remove(self->processos_prontos, proc->pid);
+  // métricas
+  metricas_muda_estado(proc->num, BLOQUEADO);
+}
+
+// bloqueia um processo esperando pelo dispositivo 'dispositivo', colocando-o
+//   no final da fila de espera desse dispositivo
+// o desbloqueio é feito no atendimento da interrupção do dispositivo, quando
+//   ele estiver pronto e o processo for o primeiro da fila
+static void processo_bloqueia_em_dispositivo(so_t *self, processo_t *proc,
+                                             int dispositivo, Fila *espera)
+{
+  proc->estado = BLOQUEADO;
+  proc->dispositivo_causou_bloqueio = dispositivo;
+  fila_enque(espera, proc->pid);
+  rastro_registra(RASTRO_BLOQUEIA, proc->pid, dispositivo, 0);
+  fila_remove(self->processos_prontos, proc->pid);
+  // métricas
+  metricas_muda_estado(proc->num, BLOQUEADO);
+}
+
+// bloqueia um processo esperando o fim do processo 'pid'
+// o desbloqueio é feito em processo_mata, na morte do processo esperado
+static void processo_bloqueia_esperando_proc(so_t *self, processo_t *proc, int pid)
+{
+  proc->estado = BLOQUEADO;
+  proc->pid_esperado = pid;
+  rastro_registra(RASTRO_BLOQUEIA, proc->pid, RASTRO_ESPERA_PROC, pid);
+  fila_remove(self->processos_prontos, proc->pid);
+  // métricas
+  metricas_muda_estado(proc->num, BLOQUEADO);
+}
+
+// retorna o número do terminal do processo (0 a N_TERMINAIS-1), ou -1
+static int processo_num_terminal(processo_t *proc)
+{
+  if (proc->terminal < 0) return -1;
+  return (proc->terminal - D_TERM_A) / (D_TERM_B - D_TERM_A);
+}
+
+// posição da chamada 'id_chamada' nos vetores de estat_eventos_t; as
+//   chamadas desconhecidas ficam todas na posição 0, que não tem nome
+static int so_indice_chamada(int id_chamada)
+{
+  if (id_chamada > 0 && id_chamada < N_CHAMADAS && nome_chamada[id_chamada] != NULL) {
+    return id_chamada;
+  }
+  return 0;
+}
+
+static char *so_nome_chamada(int id_chamada)
+{
+  int i = so_indice_chamada(id_chamada);
+  return (i == 0) ? "desconhecida" : nome_chamada[i];
+}
+
+// registra uma latência no histograma total e no do processo
+static void so_registra_latencia(estat_t *total, estat_t *do_processo, int inicio)
+{
+  int latencia = relogio_agora() - inicio;
+  estat_registra(total, latencia);
+  estat_registra(do_processo, latencia);
+}
+
+// o processo pode executar de novo: termina a medida do atendimento da falta
+//   de página ou da chamada de sistema que ele estava esperando
+static void processo_termina_latencias(so_t *self, processo_t *proc)
+{
+  if (proc->data_falta_pagina != SEM_DATA) {
+    so_registra_latencia(self->estat.latencia_falta_pagina,
+                         proc->estat.latencia_falta_pagina, proc->data_falta_pagina);
+    proc->data_falta_pagina = SEM_DATA;
+  }
+  if (proc->data_chamada != SEM_DATA) {
+    int i = so_indice_chamada(proc->id_chamada);
+    char *nome = so_nome_chamada(proc->id_chamada);
+    if (self->estat.latencia_chamada[i] == NULL) {
+      self->estat.latencia_chamada[i] = estat_histograma("latencia.chamada.%s", nome);
+    }
+    if (proc->estat.latencia_chamada[i] == NULL) {
+      proc->estat.latencia_chamada[i] = estat_histograma("proc.%d.latencia.chamada.%s",
+                                                         proc->num, nome);
+    }
+    so_registra_latencia(self->estat.latencia_chamada[i], proc->estat.latencia_chamada[i],
+                         proc->data_chamada);
+    proc->data_chamada = SEM_DATA;
+  }
+}
+
+// desbloqueia um processo, colocando ele no final da fila de prontos
+static void processo_desbloqueia(so_t *self, processo_t *proc)
+{
+  proc->estado = PRONTO;
+  proc->dispositivo_causou_bloqueio = SEM_DISPOSITIVO;
+  proc->data_desbloqueio = 0;
+  fila_enque(self->processos_prontos, proc->pid);
+  rastro_registra(RASTRO_DESBLOQUEIA, proc->pid, 0, 0);
+  processo_termina_latencias(self, proc);
+  // métricas
+  metricas_muda_estado(proc->num, PRONTO);
 }
 
 
@@ -407,7 +702,7 @@ static void processo_atualiza_prioridade(processo_t *proc){
 // ---------------------------------------------------------------------
 
 so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_secundaria, mmu_t *mmu,
-              es_t *es, console_t *console)
+              es_t *es, console_t *console, config_t *config)
 {
   so_t *self = malloc(sizeof(*self));
   if (self == NULL) return NULL;
@@ -418,16 +713,28 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_secundaria, mmu_t *mmu,
   self->mmu = mmu;
   self->es = es;
   self->console = console;
+  self->config = *config;
   self->erro_interno = false;
+  self->cpu_com_processo = false;
   self->mem2_livre = true;
   self->mem2_tempo_ate_livre = 0;
 
-  self->tabquadros = malloc(MEM_TAM / TAM_PAGINA * sizeof(quadro_t));
+  self->tam_pagina = mmu_tam_pagina(mmu);
+  self->n_quadros = mem_tam(mem) / self->tam_pagina;
+  self->tabquadros = malloc(self->n_quadros * sizeof(quadro_t));
   assert(self->tabquadros != NULL);
-  for (int i = 0; i < MEM_TAM/TAM_PAGINA; i++){
+  for (int i = 0; i < self->n_quadros; i++){
     self->tabquadros[i].pagina = -1;
     self->tabquadros[i].pid = SEM_PROCESSO;
   }
+  self->n_quadros_mem2 = mem_tam(mem_secundaria) / self->tam_pagina;
+  self->tabquadros_mem2 = malloc(self->n_quadros_mem2 * sizeof(quadro_t));
+  assert(self->tabquadros_mem2 != NULL);
+  for (int i = 0; i < self->n_quadros_mem2; i++){
+    self->tabquadros_mem2[i].pagina = -1;
+    self->tabquadros_mem2[i].pid = SEM_PROCESSO;
+  }
+  self->ponteiro_relogio = 0;
 
   // tabela de processo
   self->tabela_de_processos = malloc(N_MAX_PROCESSOS * sizeof(processo_t));
@@ -439,10 +746,48 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_secundaria, mmu_t *mmu,
   self->n_processos_tabela = 0;
   self->processo_atual = &self->tabela_de_processos[0];
   self->processos_prontos = fila_cria();
+  self->desbloqueios = agenda_cria();
+  self->imagens = imagens_cria(self->config.orcamento_imagens);
+  self->data_proxima_amostra = 0;
+
+  // estatísticas do sistema todo (as de processo são obtidas na criação
+  //   de cada processo)
+  self->estat.faltas_pagina = estat_contador("mem.faltas_pagina");
+  self->estat.paginas_carregadas = estat_contador("mem.paginas_carregadas");
+  self->estat.paginas_gravadas = estat_contador("mem.paginas_gravadas");
+  self->estat.latencia_falta_pagina = estat_histograma("latencia.falta_pagina");
+  for (int i = 0; i < N_CHAMADAS; i++) {
+    self->estat.chamadas[i] = NULL;
+    self->estat.latencia_chamada[i] = NULL;
+  }
+  self->estat_quadros_liberados = estat_contador("mem.quadros_liberados");
+  self->estat_quadros_ocupados = estat_medidor("mem.quadros_ocupados");
+  self->estat_quadros_mem2_ocupados = estat_medidor("mem2.quadros_ocupados");
+  self->estat_prontos = estat_medidor("processos.prontos");
+  self->estat_bloqueados = estat_medidor("processos.bloqueados");
+
+  // rastro de eventos, gravado no fim ou pelo comando 'T' da console
+  char nome_rastro[TAM_TEXTO_CONFIG + 20];
+  config_nome_arquivo(&self->config, "rastro", nome_rastro, sizeof(nome_rastro));
+  rastro_inicializa(nome_rastro);
+
+  // perfil de execução, gravado no fim
+  self->perfil = NULL;
+  if (self->config.perfil > 0) {
+    self->perfil = perfil_cria();
+    cpu_define_amostragem(self->cpu, self->config.perfil, so_amostra_perfil, self);
+  }
 
   // inicializa terminais
   for (int i = 0; i < N_TERMINAIS; i++){
     self->terminais_usados[i] = SEM_PROCESSO;
+    self->espera_teclado[i] = fila_cria();
+    self->espera_tela[i] = fila_cria();
+    self->saida[i].ini = 0;
+    self->saida[i].n = 0;
+    self->entrada[i].ini = 0;
+    self->entrada[i].n = 0;
+    self->entrada[i].n_linhas = 0;
   }
 
   // quando a CPU executar uma instrução CHAMAC, deve chamar a função
@@ -459,9 +804,37 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_secundaria, mmu_t *mmu,
   return self;
 }
 
+static void so_amostra_estatisticas(so_t *self);
+
 void so_destroi(so_t *self)
 {
+  // última amostra, e exporta as estatísticas
+  so_amostra_estatisticas(self);
+  char json[TAM_TEXTO_CONFIG + 20], csv[TAM_TEXTO_CONFIG + 20];
+  config_nome_arquivo(&self->config, "estatisticas.json", json, sizeof(json));
+  config_nome_arquivo(&self->config, "estatisticas.csv", csv, sizeof(csv));
+  if (!estat_exporta_json(json) || !estat_exporta_csv(csv)) {
+    depura(DEP_PROC, NIVEL_ERRO, "SO: erro na escrita das estatísticas");
+  }
+  if (!rastro_grava()) {
+    depura(DEP_PROC, NIVEL_ERRO, "SO: erro na escrita do rastro em '%s'", rastro_nome_arquivo());
+  }
+  if (self->perfil != NULL) {
+    char nome[TAM_TEXTO_CONFIG + 20];
+    config_nome_arquivo(&self->config, "perfil", nome, sizeof(nome));
+    if (!perfil_grava(self->perfil, nome)) {
+      depura(DEP_PROC, NIVEL_ERRO, "SO: erro na escrita do perfil em '%s'", nome);
+    }
+    cpu_define_amostragem(self->cpu, 0, NULL, NULL);
+    perfil_destroi(self->perfil);
+  }
   cpu_define_chamaC(self->cpu, NULL, NULL);
+  agenda_destroi(self->desbloqueios);
+  imagens_destroi(self->imagens);
+  for (int i = 0; i < N_TERMINAIS; i++) {
+    fila_destroi(self->espera_teclado[i]);
+    fila_destroi(self->espera_tela[i]);
+  }
   free(self);
 }
 
@@ -493,12 +866,18 @@ static int so_despacha(so_t *self);
 //   outra interrupção
 static int so_trata_interrupcao(void *argC, int reg_A)
 {
+  CRONOMETRO_INICIO(t);
   so_t *self = argC;
   irq_t irq = reg_A;
   // esse print polui bastante, recomendo tirar quando estiver com mais confiança
-  console_printf("SO: recebi IRQ %d (%s)", irq, irq_nome(irq));
+  depura(DEP_IRQ, NIVEL_DETALHE, "SO: recebi IRQ %d (%s)", irq, irq_nome(irq));
   // salva o estado da cpu no descritor do processo que foi interrompido
   so_salva_estado_da_cpu(self);
+  if (self->cpu_com_processo) {
+    rastro_registra(RASTRO_IRQ, self->processo_atual->pid, irq, self->processo_atual->regPC);
+  } else {
+    rastro_registra(RASTRO_IRQ, 0, irq, 0);
+  }
   // faz o atendimento da interrupção
   so_trata_irq(self, irq);
   // faz o processamento independente da interrupção
@@ -506,7 +885,14 @@ static int so_trata_interrupcao(void *argC, int reg_A)
   // escolhe o próximo processo a executar
   so_escalona(self);
   // recupera o estado do processo escolhido
-  return so_despacha(self);
+  int ret = so_despacha(self);
+  if (self->cpu_com_processo) {
+    rastro_registra(RASTRO_DESPACHA, self->processo_atual->pid, self->processo_atual->regPC, 0);
+  } else {
+    rastro_registra(RASTRO_DESPACHA, 0, 0, 0);
+  }
+  CRONOMETRO_FIM(CRONO_SO, t);
+  return ret;
 }
 
 static void so_salva_estado_da_cpu(so_t *self)
@@ -518,7 +904,8 @@ static void so_salva_estado_da_cpu(so_t *self)
   // se não houver processo corrente, não faz nada
   
   // se for NULL ou SEM_PROCESSO, não salva
-  if (self->processo_atual->pid == SEM_PROCESSO) {
+  // se a CPU estava parada, o estado na memória não é de processo nenhum
+  if (!self->cpu_com_processo || self->processo_atual->pid == SEM_PROCESSO) {
     return;
   }
 
@@ -529,7 +916,7 @@ static void so_salva_estado_da_cpu(so_t *self)
       || mem_le(self->mem, CPU_END_erro, &self->processo_atual->regERRO) != ERR_OK
       || mem_le(self->mem, CPU_END_complemento, &self->processo_atual->regComplemento) != ERR_OK
       || mem_le(self->mem, 59, &self->processo_atual->regX)) {
-    console_printf("SO: erro na leitura dos registradores");
+    depura(DEP_IRQ, NIVEL_ERRO, "SO: erro na leitura dos registradores");
     self->erro_interno = true;
   }
 
@@ -541,73 +928,241 @@ static void so_salva_estado_da_cpu(so_t *self)
   self->processo_atual->regX = self->processo_atual->regX;
 }
 
+// retorna o processo com o pid, se ele ainda estiver bloqueado esperando o
+//   dispositivo 'dispositivo', ou NULL
+static processo_t *so_processo_esperando(so_t *self, int pid, int dispositivo)
+{
+  int indice = acha_indice_por_pid(self, pid);
+  if (indice == SEM_PROCESSO) return NULL;
+  processo_t *p = &self->tabela_de_processos[indice];
+  if (p->estado != BLOQUEADO || p->dispositivo_causou_bloqueio != dispositivo) {
+    return NULL;
+  }
+  return p;
+}
+
+// passa para o buffer de entrada do terminal 't' os caracteres disponíveis
+//   no teclado, enquanto couberem
+// retorna false em caso de erro no acesso ao terminal
+static bool so_enche_entrada(so_t *self, int t)
+{
+  entrada_t *entrada = &self->entrada[t];
+  int terminal = D_TERM_A + t * (D_TERM_B - D_TERM_A);
+  while (entrada->n < TAM_ENTRADA) {
+    int disponivel;
+    if (es_le(self->es, terminal + TERM_TECLADO_OK, &disponivel) != ERR_OK) {
+      depura(DEP_ES, NIVEL_ERRO, "SO: problema no acesso ao estado do teclado");
+      self->erro_interno = true;
+      return false;
+    }
+    if (!disponivel) break;
+    int dado;
+    if (es_le(self->es, terminal + TERM_TECLADO, &dado) != ERR_OK) {
+      depura(DEP_ES, NIVEL_ERRO, "SO: problema no acesso ao teclado");
+      self->erro_interno = true;
+      return false;
+    }
+    entrada->buf[(entrada->ini + entrada->n) % TAM_ENTRADA] = dado;
+    entrada->n++;
+    if (dado == '\n') entrada->n_linhas++;
+  }
+  return true;
+}
+
+// retira o primeiro caractere do buffer de entrada, que não pode estar vazio
+static int so_tira_da_entrada(entrada_t *entrada)
+{
+  int dado = entrada->buf[entrada->ini];
+  entrada->ini = (entrada->ini + 1) % TAM_ENTRADA;
+  entrada->n--;
+  if (dado == '\n') entrada->n_linhas--;
+  return dado;
+}
+
+// tenta completar com o buffer de entrada do terminal 't' o pedido de
+//   leitura do processo 'proc': um caractere (SO_LE) ou uma linha
+//   (SO_LE_LINHA), para o vetor cujo endereço está em X
+// a linha só é entregue quando tiver um fim de linha no buffer, ou quando
+//   tiver caracteres suficientes para encher o vetor do processo ou o
+//   buffer
+// retorna true se a chamada foi completada (com o resultado no A do
+//   processo), false se ainda não tem o que entregar
+static bool so_le_da_entrada(so_t *self, int t, processo_t *proc)
+{
+  entrada_t *entrada = &self->entrada[t];
+  if (!so_enche_entrada(self, t)) return false;
+  if (proc->regA == SO_LE) {
+    if (entrada->n == 0) return false;
+    proc->regA = so_tira_da_entrada(entrada);
+    return true;
+  }
+  int tam;
+  if (so_le_mem_processo(self, proc, proc->regX, &tam) != ERR_OK || tam < 0) {
+    depura(DEP_ES, NIVEL_AVISO,
+           "SO: processo %d tentou ler linha para o endereço inválido %d",
+           proc->pid, proc->regX);
+    proc->regA = -1;
+    return true;
+  }
+  if (entrada->n_linhas == 0 && entrada->n < tam && entrada->n < TAM_ENTRADA) {
+    return false;
+  }
+  int n = 0;
+  while (entrada->n > 0 && n < tam) {
+    int dado = so_tira_da_entrada(entrada);
+    if (dado == '\n') break;
+    if (so_escreve_mem_processo(self, proc, proc->regX + 1 + n, dado) != ERR_OK) {
+      proc->regA = -1;
+      return true;
+    }
+    n++;
+  }
+  // o vetor encheu bem no fim da linha: o fim de linha também é consumido
+  if (n == tam && entrada->n > 0 && entrada->buf[entrada->ini] == '\n') {
+    so_tira_da_entrada(entrada);
+  }
+  if (so_escreve_mem_processo(self, proc, proc->regX + 1 + n, 0) != ERR_OK) {
+    proc->regA = -1;
+    return true;
+  }
+  proc->regA = n;
+  // pode ter aberto espaço para o que ficou esperando no teclado
+  so_enche_entrada(self, t);
+  return true;
+}
+
+// lê para o buffer de entrada o que chegou no teclado do terminal 't' e faz
+//   as leituras pendentes, na ordem em que os processos bloquearam,
+//   desbloqueando os que forem completados
+// chamada no atendimento da interrupção de teclado
+static void so_atende_espera_teclado(so_t *self, int t)
+{
+  Fila *espera = self->espera_teclado[t];
+  int terminal = D_TERM_A + t * (D_TERM_B - D_TERM_A);
+  if (!so_enche_entrada(self, t)) return;
+  while (!fila_vazia(espera)) {
+    int pid = fila_get(espera, 0);
+    processo_t *p = so_processo_esperando(self, pid, terminal + TERM_TECLADO);
+    if (p != NULL) {
+      if (!so_le_da_entrada(self, t, p)) return;
+      processo_desbloqueia(self, p);
+    }
+    fila_deque(espera);
+  }
+}
+
+// escreve na tela do terminal 't' os caracteres do buffer de saída, enquanto
+//   a tela aceitar
+// retorna false em caso de erro no acesso ao terminal
+static bool so_esvazia_saida(so_t *self, int t)
+{
+  saida_t *saida = &self->saida[t];
+  int terminal = D_TERM_A + t * (D_TERM_B - D_TERM_A);
+  while (saida->n > 0) {
+    int disponivel;
+    if (es_le(self->es, terminal + TERM_TELA_OK, &disponivel) != ERR_OK) {
+      depura(DEP_ES, NIVEL_ERRO, "SO: problema no acesso ao estado da tela");
+      self->erro_interno = true;
+      return false;
+    }
+    if (!disponivel) break;
+    if (es_escreve(self->es, terminal + TERM_TELA, saida->buf[saida->ini]) != ERR_OK) {
+      depura(DEP_ES, NIVEL_ERRO, "SO: problema no acesso à tela");
+      self->erro_interno = true;
+      return false;
+    }
+    saida->ini = (saida->ini + 1) % TAM_SAIDA;
+    saida->n--;
+  }
+  return true;
+}
+
+// copia para o buffer de saída do terminal 't' o que o processo 'proc' pediu
+//   para escrever: o caractere em X (SO_ESCR) ou a string que começa no
+//   endereço em X (SO_ESCR_STR)
+// quando o buffer enche, tenta esvaziá-lo na tela antes de continuar; o
+//   end_escrita de SO_ESCR_STR avança a cada caractere copiado, para que a
+//   cópia possa continuar de onde parou se o processo tiver que bloquear (o
+//   X do processo não é alterado)
+// retorna true se a chamada foi completada (com o resultado no A do
+//   processo), false se o buffer ficou cheio antes
+static bool so_escreve_na_saida(so_t *self, int t, processo_t *proc)
+{
+  saida_t *saida = &self->saida[t];
+  for (;;) {
+    if (saida->n == TAM_SAIDA) {
+      if (!so_esvazia_saida(self, t) || saida->n == TAM_SAIDA) return false;
+    }
+    int dado;
+    if (proc->regA == SO_ESCR) {
+      dado = proc->regX;
+    } else if (so_le_mem_processo(self, proc, proc->end_escrita, &dado) != ERR_OK) {
+      depura(DEP_ES, NIVEL_AVISO,
+             "SO: processo %d tentou escrever string no endereço inválido %d",
+             proc->pid, proc->end_escrita);
+      proc->regA = -1;
+      break;
+    } else if (dado == 0) {
+      proc->regA = 0;
+      break;
+    }
+    saida->buf[(saida->ini + saida->n) % TAM_SAIDA] = dado;
+    saida->n++;
+    if (proc->regA == SO_ESCR) {
+      proc->regA = 0;
+      break;
+    }
+    proc->end_escrita++;
+  }
+  so_esvazia_saida(self, t);
+  return true;
+}
+
+// escreve na tela do terminal 't' o que estiver no buffer de saída e passa
+//   para o buffer as escritas dos processos que estão esperando, na ordem em
+//   que bloquearam, desbloqueando os que forem completados
+// chamada no atendimento da interrupção de tela
+static void so_atende_espera_tela(so_t *self, int t)
+{
+  Fila *espera = self->espera_tela[t];
+  int terminal = D_TERM_A + t * (D_TERM_B - D_TERM_A);
+  if (!so_esvazia_saida(self, t)) return;
+  while (!fila_vazia(espera)) {
+    int pid = fila_get(espera, 0);
+    processo_t *p = so_processo_esperando(self, pid, terminal + TERM_TELA);
+    if (p != NULL) {
+      if (!so_escreve_na_saida(self, t, p)) return;
+      processo_desbloqueia(self, p);
+    }
+    fila_deque(espera);
+  }
+}
+
 static void so_trata_pendencias(so_t *self)
 {
   // t2: realiza ações que não são diretamente ligadas com a interrupção que
   //   está sendo atendida:
-  // - E/S pendente
+  // - E/S pendente (agora atendida nas interrupções de teclado e tela)
   // - desbloqueio de processos
   // - contabilidades
   // - etc
 
-  for (int i = 0; i < N_MAX_PROCESSOS; i++)
-  {
-    processo_t *p = &self->tabela_de_processos[i];
-    if (p->estado == BLOQUEADO)
-    {
-      // verifica o dispositivo que causou o bloqueio
-      int dispositivo = p->dispositivo_causou_bloqueio;
-      int operacao = dispositivo % 4;
-
-      // verifica o estado do dispositivo
-      int disponivel;
-      int estado = es_le(self->es, dispositivo, &disponivel);
-      if (estado != ERR_OK)
-      {
-        // realiza a operação pendente
-        // leitura
-        if (operacao == 1)
-        {
-          int dado;
-          if (es_le(self->es, dispositivo-1, &dado) != ERR_OK) {
-            console_printf("SO: problema no acesso ao teclado");
-            self->erro_interno = true;
-            return;
-          }
-          p->regA = dado;
-        }
-        // escrita
-        if (operacao == 3)
-        {
-          int dado = p->regX;
-          if (es_escreve(self->es, dispositivo-1, dado) != ERR_OK) {
-            console_printf("SO: problema no acesso à tela");
-            self->erro_interno = true;
-            return;
-          }
-          p->regA = 0;
-        }
-      }
-
-      // desbloqueia o processo se tiver na hora
-      int agora = relogio_agora();
-      // ADICIONADO: p->data_desbloqueio > 0
-      if (p->data_desbloqueio > 0 && p->data_desbloqueio <= agora)
-      {
-        p->estado = PRONTO;
-        p->dispositivo_causou_bloqueio = SEM_DISPOSITIVO; // Limpa flag de E/S se houver
-        p->data_desbloqueio = 0; // Limpa o tempo para não entrar aqui de novo
-        
-        // Métricas e Fila (Igual ao seu código)
-        // Nota: Se estiver usando a função do colega, use acha_indice_por_pid
-        // Se for a sua tabela direta, use apenas 'i'
-        metricas.n_prontos[i]++; 
-        fila_enque(self->processos_prontos, p->pid);
-        
-        console_printf("SO: PID %d desbloqueado (fim do swap)", p->pid);
-      }
-
-    }
+  // desbloqueia os processos cuja data de desbloqueio já chegou
+  // só olha o início da agenda, os processos que ainda têm que esperar
+  //   não são visitados
+  int agora = relogio_agora();
+  while (!agenda_vazia(self->desbloqueios)
+         && agenda_proxima_data(self->desbloqueios) <= agora) {
+    int data;
+    int pid = agenda_remove(self->desbloqueios, &data);
+    int indice = acha_indice_por_pid(self, pid);
+    if (indice == SEM_PROCESSO) continue;  // morreu enquanto esperava
+    processo_t *p = &self->tabela_de_processos[indice];
+    // o evento pode ser antigo, de outro bloqueio (ou de outro processo com o
+    //   mesmo pid)
+    if (p->estado != BLOQUEADO || p->data_desbloqueio != data) continue;
+    processo_desbloqueia(self, p);
+    depura(DEP_PROC, NIVEL_DETALHE, "SO: PID %d desbloqueado (data %d)", p->pid, data);
   }
 }
 
@@ -619,26 +1174,23 @@ static void so_escalona(so_t *self)
   //   corrente não possa continuar executando, senão deixa o mesmo processo.
   //   depois, implementa um escalonador melhor
 
-  // verifica se o processo corrente está em execução
-  if (self->processo_atual->estado == EXECUTANDO) return;
+  // verifica se o processo corrente está em execução (com prioridade, ele
+  //   ainda pode perder a CPU para um processo que ficou pronto)
+  if (self->processo_atual->estado == EXECUTANDO
+      && self->config.escalonador != PRIORIDADE) return;
 
-  switch (ESCALONADOR){
+  switch (self->config.escalonador){
     case ROUND_ROBIN:
       // pega o primeiro processo da fila de processos prontos
       int pid_escalonado = fila_get(self->processos_prontos, 0);
-      
-      // >>> DEBUG AQUI <<<
-      console_printf("DEBUG: Round-Robin olhou a fila. Primeiro PID: %d", pid_escalonado);
+      depura(DEP_PROC, NIVEL_DETALHE, "SO: round-robin, primeiro da fila de prontos: PID %d",
+             pid_escalonado);
 
       for (int i = 0; i < N_MAX_PROCESSOS; i++){
       
         if (self->tabela_de_processos[i].pid == pid_escalonado && pid_escalonado != -1){
           // torna-o o processo atual
-          self->processo_atual = &self->tabela_de_processos[i];
-          // métricas ATENÇÃO, TEM MÉTRICAS AQUI AINDA?
-          metricas.processos_estado[i] = EXECUTANDO;
-          metricas.n_execucao[i]++;
-          
+          processo_executa(self, &self->tabela_de_processos[i]);
         }
       }
       break;
@@ -646,12 +1198,15 @@ static void so_escalona(so_t *self)
     case PRIORIDADE:
       // pega o indice do processo com a maior prioridade na tabela de processos (menor valor do campo ->prioridade)
       int indice_maior_prioridade = SEM_PROCESSO;
-      float maior_prioridade = QUANTUM; 
+      float maior_prioridade = self->config.quantum; 
 
       for (int i = 0; i < N_MAX_PROCESSOS; i++){
         if (self->tabela_de_processos[i].estado == FINALIZADO || self->tabela_de_processos[i].pid == SEM_PROCESSO) continue;
 
-        if (self->tabela_de_processos[i].prioridade < maior_prioridade && self->tabela_de_processos[i].estado == PRONTO){
+        // o processo corrente, se ainda estiver executando, também concorre
+        bool pode_executar = self->tabela_de_processos[i].estado == PRONTO
+                             || self->tabela_de_processos[i].estado == EXECUTANDO;
+        if (self->tabela_de_processos[i].prioridade < maior_prioridade && pode_executar){
           indice_maior_prioridade = i;
           maior_prioridade = self->tabela_de_processos[i].prioridade;
         }
@@ -659,13 +1214,11 @@ static void so_escalona(so_t *self)
       
       // escalona o processo de maior prioridade
       if (indice_maior_prioridade != SEM_PROCESSO){
-        self->processo_atual = &self->tabela_de_processos[indice_maior_prioridade];
-        // t3, ainda nao implementado
-        //mmu_define_tabpag(self->mmu, self->processo_corrente->tabgpag);
-        
-        // metricas ATENÇÃO
-        metricas.processos_estado[indice_maior_prioridade] = EXECUTANDO;
-        metricas.n_execucao[indice_maior_prioridade]++;
+        processo_t *escolhido = &self->tabela_de_processos[indice_maior_prioridade];
+        if (escolhido != self->processo_atual && self->processo_atual->estado == EXECUTANDO) {
+          processo_preempta(self->processo_atual);
+        }
+        processo_executa(self, escolhido);
       }else{
         // apenas tem um processo na tabela - deixa ele corrente
         processo_troca_corrente(self);
@@ -673,7 +1226,7 @@ static void so_escalona(so_t *self)
       break;
 
     default:
-      console_printf("NENHUM\n");
+      depura(DEP_PROC, NIVEL_DETALHE, "NENHUM\n");
       // bota o primeiro processo PRONTO para executar
       processo_troca_corrente(self);
   }
@@ -690,21 +1243,24 @@ static void so_escalona(so_t *self)
       }
     } 
   }
-  if (n_proc_bloqueados == n_proc_vivos){
-    metricas.so_oscioso = true;
-  } else{
-    metricas.so_oscioso = false;
-  }
-
-  // (metricas) aumenta o número de preempções
-  metricas.n_preempcoes++;
+  metricas_define_oscioso(n_proc_bloqueados == n_proc_vivos);
 
-  console_printf("Processo escalonado!\n");
+  depura(DEP_PROC, NIVEL_DETALHE, "Processo escalonado!\n");
   
   // verifica se todos os processos encerraram
   if (todos_processos_encerrados(self)){
-    console_printf("TODOS PROCESSOS ENCERRARAM - %d\n", metricas.n_processos_criados);
-    metricas_imprime();
+    depura(DEP_PROC, NIVEL_DETALHE, "TODOS PROCESSOS ENCERRARAM - %d\n", metricas.n_processos_criados);
+    char relatorio[TAM_TEXTO_CONFIG + 20];
+    config_nome_arquivo(&self->config, "relatorio.txt", relatorio, sizeof(relatorio));
+    metricas_imprime(relatorio, cpu_contadores(self->cpu));
+  }
+
+  // sem console, ninguém vai mandar parar: para quando os processos terminam
+  //   ou quando o relógio passa do limite
+  if (!self->config.console
+      && (todos_processos_encerrados(self)
+          || (self->config.limite > 0 && relogio_agora() >= self->config.limite))) {
+    console_insere_comando(self->console, 'F');
   }
 }
 
@@ -717,7 +1273,11 @@ static int so_despacha(so_t *self)
   //   registrador A para o tratador de interrupção (ver trata_irq.asm).
   
   // se não tem processo válido pra rodar, retorna 1
+  // um processo bloqueado não pode rodar, mesmo que ainda seja o atual (a fila
+  //   de prontos estava vazia na hora de escalonar)
+  self->cpu_com_processo = false;
   if (self->processo_atual->pid == SEM_PROCESSO) return 1;
+  if (self->processo_atual->estado == BLOQUEADO) return 1;
 
   // NOVO: configura a MMU para o processo atual
   // o processo_corrente->tabpag contém a tabela de paginas individual
@@ -727,66 +1287,181 @@ static int so_despacha(so_t *self)
       || mem_escreve(self->mem, CPU_END_PC, self->processo_atual->regPC) != ERR_OK
       || mem_escreve(self->mem, CPU_END_erro, self->processo_atual->regERRO) != ERR_OK
       || mem_escreve(self->mem, 59, self->processo_atual->regX)) {
-    console_printf("SO: erro na escrita dos registradores");
+    depura(DEP_IRQ, NIVEL_ERRO, "SO: erro na escrita dos registradores");
     self->erro_interno = true;
   }
   if (self->erro_interno) return 1;
-  else return 0;
+  self->cpu_com_processo = true;
+  return 0;
+}
+
+// procura um quadro livre na memória secundária
+static int acha_quadro_livre_mem2(so_t *self)
+{
+  for (int i = 0; i < self->n_quadros_mem2; i++) {
+    if (self->tabquadros_mem2[i].pid == SEM_PROCESSO) return i;
+  }
+  depura(DEP_MEM, NIVEL_AVISO, "SO: memória secundária cheia");
+  return -1;
+}
+
+// dá um quadro da memória secundária para a página 'pagina' do processo
+// retorna o quadro, ou -1 se a memória secundária estiver cheia
+static int so_aloca_quadro_mem2(so_t *self, processo_t *proc, int pagina)
+{
+  int quadro = acha_quadro_livre_mem2(self);
+  if (quadro < 0) return -1;
+  self->tabquadros_mem2[quadro].pid = proc->pid;
+  self->tabquadros_mem2[quadro].pagina = pagina;
+  proc->quadro_mem2[pagina] = quadro;
+  return quadro;
+}
+
+// coloca em '*pvalor' o valor do endereço virtual 'end_virt' do processo
+//   'proc' que está fora da memória principal: no quadro da memória
+//   secundária, se a página já foi alterada, senão na imagem do programa
+static err_t so_le_fora_da_mem(so_t *self, processo_t *proc, int end_virt,
+                               int *pvalor)
+{
+  int quadro = proc->quadro_mem2[end_virt / self->tam_pagina];
+  if (quadro != SEM_QUADRO) {
+    return mem_le(self->mem2, quadro * self->tam_pagina + end_virt % self->tam_pagina, pvalor);
+  }
+  // a última página pode ir além do fim do programa
+  if (end_virt >= proc->tam_mem_virt) {
+    *pvalor = 0;
+  } else {
+    *pvalor = prog_dado(proc->imagem, end_virt);
+  }
+  return ERR_OK;
+}
+
+// escolhe o quadro da memória principal a ser liberado, com o algoritmo do
+//   relógio: uma página que foi acessada desde a última passagem do ponteiro
+//   tem o bit de acesso zerado e ganha mais uma chance
+// retorna -1 se não tiver nenhum quadro de processo
+static int so_escolhe_quadro_vitima(so_t *self)
+{
+  for (int passos = 0; passos < 2 * self->n_quadros; passos++) {
+    int quadro = self->ponteiro_relogio;
+    self->ponteiro_relogio = (quadro + 1) % self->n_quadros;
+    int indice = acha_indice_por_pid(self, self->tabquadros[quadro].pid);
+    if (indice == SEM_PROCESSO) continue;  // livre ou protegido
+    tabpag_t *tabpag = self->tabela_de_processos[indice].tabpag;
+    int pagina = self->tabquadros[quadro].pagina;
+    if (tabpag_bit_acesso(tabpag, pagina)) {
+      tabpag_zera_bit_acesso(tabpag, pagina);
+      continue;
+    }
+    return quadro;
+  }
+  return -1;
+}
+
+// tira da memória principal a página que está no quadro 'quadro'
+// uma página alterada é copiada para a memória secundária, num quadro que
+//   ela ganha na primeira vez que isso acontece; as outras não precisam ser
+//   copiadas, porque a memória secundária ou a imagem já tem o conteúdo delas
+// retorna o número de páginas transferidas (0 ou 1), ou -1 se erro
+static int so_libera_quadro(so_t *self, int quadro)
+{
+  processo_t *dono = &self->tabela_de_processos[acha_indice_por_pid(self, self->tabquadros[quadro].pid)];
+  int pagina = self->tabquadros[quadro].pagina;
+  int transferencias = 0;
+  rastro_registra(RASTRO_SUBSTITUI, dono->pid, quadro, pagina);
+
+  if (tabpag_bit_alteracao(dono->tabpag, pagina)) {
+    int quadro_mem2 = dono->quadro_mem2[pagina];
+    if (quadro_mem2 == SEM_QUADRO) {
+      quadro_mem2 = so_aloca_quadro_mem2(self, dono, pagina);
+      if (quadro_mem2 < 0) return -1;
+    }
+    for (int offset = 0; offset < self->tam_pagina; offset++) {
+      int dado;
+      if (mem_le(self->mem, quadro * self->tam_pagina + offset, &dado) != ERR_OK
+          || mem_escreve(self->mem2, quadro_mem2 * self->tam_pagina + offset, dado) != ERR_OK) {
+        return -1;
+      }
+    }
+    transferencias = 1;
+    estat_soma(dono->estat.paginas_gravadas, 1);
+    estat_soma(self->estat.paginas_gravadas, 1);
+  }
+  estat_soma(self->estat_quadros_liberados, 1);
+
+  tabpag_invalida_pagina(dono->tabpag, pagina);
+  self->tabquadros[quadro].pid = SEM_PROCESSO;
+  self->tabquadros[quadro].pagina = -1;
+  depura(DEP_MEM, NIVEL_DETALHE, "SO: quadro %d liberado (pagina %d do processo %d%s)",
+         quadro, pagina, dono->pid, transferencias ? ", copiada para a memória secundária" : "");
+  return transferencias;
 }
 
-//page_fault_tratavel usa agora proc->end_disco (físico) para calcular a posição 
-//correta em mem_fisica a ser lida e copiar para um quadro físico livre 
-//em mem principal.
+// carrega a página do endereço 'end_causador' do processo corrente num
+//   quadro da memória principal, liberando um quadro se não tiver nenhum livre
+// a página vem da memória secundária se já foi alterada, senão vem direto
+//   da imagem do programa
 static void page_fault_tratavel(so_t *self, int end_causador)
 {
-    processo_t *proc_corrente = self->processo_atual; // Use sua variável
-    
+    processo_t *proc_corrente = self->processo_atual;
+
+    if (end_causador < 0 || end_causador >= proc_corrente->tam_mem_virt) {
+        depura(DEP_MEM, NIVEL_AVISO, "SO: processo %d acessou o endereço %d, fora da sua memória",
+               proc_corrente->pid, end_causador);
+        processo_mata(self, proc_corrente->pid);
+        return;
+    }
+
+    estat_soma(proc_corrente->estat.faltas_pagina, 1);
+    estat_soma(self->estat.faltas_pagina, 1);
+    proc_corrente->data_falta_pagina = relogio_agora();
+    rastro_registra(RASTRO_FALTA_PAGINA, proc_corrente->pid, end_causador,
+                    end_causador / self->tam_pagina);
+
+    // páginas transferidas entre as memórias
+    int transferencias = 0;
+
     // Acha quadro livre na RAM
     int pg_livre = acha_quadro_livre(self);
-    
     if (pg_livre < 0) {
-        console_printf("SO: nenhuma pagina fisica livre para swap-in");
-        self->erro_interno = true;
-        return;
+        pg_livre = so_escolhe_quadro_vitima(self);
+        int t = (pg_livre < 0) ? -1 : so_libera_quadro(self, pg_livre);
+        if (t < 0) {
+            depura(DEP_MEM, NIVEL_ERRO, "SO: não foi possível liberar um quadro para o processo %d",
+                   proc_corrente->pid);
+            self->erro_interno = true;
+            return;
+        }
+        transferencias += t;
     }
 
-    int inicio_pagina_virtual = end_causador - (end_causador % TAM_PAGINA);
-    
-    // Calcula endereço no disco (mem2)
-    // ATENÇÃO: Ela usa end_disco como endereço linear. Você usa quadro_mem2.
-    // Com a alteração acima, quadro_mem2 agora guarda o endereço linear.
-    int ini_end_fisico = proc_corrente->quadro_mem2 + inicio_pagina_virtual; 
+    int pagina = end_causador / self->tam_pagina;
+    int inicio_pagina_virtual = pagina * self->tam_pagina;
 
-    console_printf("SO: carregando pagina do disco, início em %d (pg_livre=%d, pag_virt=%d)", 
-                   ini_end_fisico, pg_livre, inicio_pagina_virtual / TAM_PAGINA);
+    depura(DEP_MEM, NIVEL_DETALHE, "SO: carregando pagina %d %s no quadro %d", pagina,
+           proc_corrente->quadro_mem2[pagina] == SEM_QUADRO ? "da imagem" : "da memória secundária",
+           pg_livre);
 
-    // Copia Disco (mem2) -> RAM (mem)
-    for (int offset = 0; offset < TAM_PAGINA; offset++) {
+    for (int offset = 0; offset < self->tam_pagina; offset++) {
         int dado;
-        // Lê de mem2
-        if (mem_le(self->mem2, ini_end_fisico + offset, &dado) != ERR_OK) {
-             console_printf("SO: erro leitura disco");
-             self->erro_interno = true;
-             return;
-        }
-        
-        int quadro_fisico_addr = pg_livre * TAM_PAGINA + offset;
-        // Escreve em mem
-        if (mem_escreve(self->mem, quadro_fisico_addr, dado) != ERR_OK) {
-             console_printf("SO: erro escrita RAM");
+        if (so_le_fora_da_mem(self, proc_corrente, inicio_pagina_virtual + offset, &dado) != ERR_OK
+            || mem_escreve(self->mem, pg_livre * self->tam_pagina + offset, dado) != ERR_OK) {
+             depura(DEP_MEM, NIVEL_ERRO, "SO: erro na cópia da página %d do processo %d",
+                    pagina, proc_corrente->pid);
              self->erro_interno = true;
              return;
         }
     }
+    transferencias++;
+    estat_soma(proc_corrente->estat.paginas_carregadas, 1);
+    estat_soma(self->estat.paginas_carregadas, 1);
 
     // Atualiza tabela de quadros (tabquadros)
     self->tabquadros[pg_livre].pid = proc_corrente->pid;
-    self->tabquadros[pg_livre].pagina = inicio_pagina_virtual / TAM_PAGINA;
-    // Nota: Ela usa blocos_memoria[].ocupado = true, mas sua lógica de acha_quadro já marcou
+    self->tabquadros[pg_livre].pagina = pagina;
 
     // Atualiza Tabela de Páginas
     tabpag_t *tabela = proc_corrente->tabpag; // Use seu campo tabpag
-    int pagina = inicio_pagina_virtual / TAM_PAGINA;
     tabpag_define_quadro(tabela, pagina, pg_livre);
 
     // Atualiza MMU
@@ -794,9 +1469,20 @@ static void page_fault_tratavel(so_t *self, int end_causador)
 
     // Limpa o erro no processo
     proc_corrente->regERRO = ERR_OK;       // Se usar sua struct // (Opcional se o dispacher recarregar)
+
+    // o processo fica bloqueado enquanto as páginas são transferidas; o disco faz
+    //   uma transferência por vez, então a espera começa quando ele estiver livre
+    int agora = relogio_agora();
+    if (self->mem2_tempo_ate_livre < agora) self->mem2_tempo_ate_livre = agora;
+    self->mem2_tempo_ate_livre += self->config.tempo_swap * transferencias;
+    if (self->mem2_tempo_ate_livre > agora) {
+      processo_bloqueia_ate(self, proc_corrente, self->mem2_tempo_ate_livre);
+    } else {
+      processo_termina_latencias(self, proc_corrente);
+    }
     
-    console_printf("SO: pagina trocada para o processo %d, pagina virtual %d mapeada para quadro %d", 
-                   proc_corrente->pid, pagina, pg_livre);
+    depura(DEP_MEM, NIVEL_DETALHE, "SO: pagina trocada para o processo %d, pagina virtual %d mapeada para quadro %d", 
+           proc_corrente->pid, pagina, pg_livre);
 }
 
 
@@ -805,7 +1491,9 @@ static void so_trata_page_fault(so_t *self)
     processo_t *proc_corrente = self->processo_atual;
     int end_causador = self->processo_atual->regComplemento; // Pega do SO, pois foi salvo lá na IRQ
     
-    int pagina_virtual = end_causador / TAM_PAGINA;
+    // a página é calculada como na MMU: um endereço negativo não tem página,
+    //   e vai ser recusado em page_fault_tratavel
+    int pagina_virtual = mmu_pagina(self->mmu, end_causador);
     tabpag_t *tabela = proc_corrente->tabpag;
     int quadro;
 
@@ -814,7 +1502,7 @@ static void so_trata_page_fault(so_t *self)
         return;
     }
 
-    console_printf("SO: tratando page fault para endereço %d (pagina %d)", end_causador, pagina_virtual);
+    depura(DEP_MEM, NIVEL_DETALHE, "SO: tratando page fault para endereço %d (pagina %d)", end_causador, pagina_virtual);
     
     // Chama a função que faz o trabalho
     page_fault_tratavel(self, end_causador);
@@ -829,6 +1517,8 @@ static void so_trata_reset(so_t *self);
 static void so_trata_irq_chamada_sistema(so_t *self);
 static void so_trata_irq_err_cpu(so_t *self);
 static void so_trata_irq_relogio(so_t *self);
+static void so_trata_irq_teclado(so_t *self);
+static void so_trata_irq_tela(so_t *self);
 static void so_trata_irq_desconhecida(so_t *self, int irq);
 
 static void so_trata_irq(so_t *self, int irq)
@@ -851,6 +1541,14 @@ static void so_trata_irq(so_t *self, int irq)
       metricas.n_irq_relogio++; // MÉTRICAS
       so_trata_irq_relogio(self);
       break;
+    case IRQ_TECLADO:
+      metricas.n_irq_teclado++; // MÉTRICAS
+      so_trata_irq_teclado(self);
+      break;
+    case IRQ_TELA:
+      metricas.n_irq_tela++; // MÉTRICAS
+      so_trata_irq_tela(self);
+      break;
     default:
       metricas.n_irq_desconhecida++; // MÉTRICAS
       so_trata_irq_desconhecida(self, irq);
@@ -873,13 +1571,13 @@ static void so_trata_reset(so_t *self)
 
   int ender = so_carrega_programa(self, p, "trata_int.maq");
   if (ender != CPU_END_TRATADOR) {
-    console_printf("SO: problema na carga do programa de tratamento de interrupção");
+    depura(DEP_IRQ, NIVEL_ERRO, "SO: problema na carga do programa de tratamento de interrupção");
     self->erro_interno = true;
   }
 
-  // programa o relógio para gerar uma interrupção após INTERVALO_INTERRUPCAO
-  if (es_escreve(self->es, D_RELOGIO_TIMER, INTERVALO_INTERRUPCAO) != ERR_OK) {
-    console_printf("SO: problema na programação do timer");
+  // programa o relógio para gerar uma interrupção após o intervalo da configuração
+  if (es_escreve(self->es, D_RELOGIO_TIMER, self->config.intervalo_interrupcao) != ERR_OK) {
+    depura(DEP_IRQ, NIVEL_ERRO, "SO: problema na programação do timer");
     self->erro_interno = true;
   }
 
@@ -887,8 +1585,7 @@ static void so_trata_reset(so_t *self)
   //   contém o endereço final da memória protegida (que não podem ser usadas
   //   por programas de usuário)
   // t3: o controle de memória livre deve ser mais aprimorado que isso  
-  self->quadro_livre_mem = CPU_END_FIM_PROT / TAM_PAGINA + 1;
-  self->quadro_livre_mem2 = 0;
+  self->quadro_livre_mem = CPU_END_FIM_PROT / self->tam_pagina + 1;
   // marca os quadros de memória protegida como nao livres;
   for (int i = 0; i < self->quadro_livre_mem + 1; i++) self->tabquadros[i].pid = PROTEGIDO;
 
@@ -904,11 +1601,11 @@ static void so_trata_reset(so_t *self)
 
   // coloca o programa init na memória
   // chama processo_cria
-  int pid = processo_cria(self, "init.maq", NULL); 
+  int pid = processo_cria(self, self->config.init, NULL); 
 
   // ajusta o processo atual para EXECUTANDO
   processo_troca_corrente(self); 
-  console_printf("TROCOU PRO INIT"); 
+  depura(DEP_PROC, NIVEL_INFO, "TROCOU PRO INIT"); 
   self->processo_atual->estado = EXECUTANDO;
   self->processo_atual->regA = pid;
 }
@@ -919,11 +1616,11 @@ static void trata_falta_de_pagina(so_t *self, int quadro_livre)
   self->tabquadros[quadro_livre].pid = self->processo_atual->pid;
   // pega a pagina do endereço virtual que causou a interrupção
   int end = self->processo_atual->regComplemento;
-  int pagina = end / TAM_PAGINA;
+  int pagina = end / self->tam_pagina;
   // copia a página da memória secundária para o quadro livre
-  int end_virt_ini = pagina * TAM_PAGINA;
-  int end_virt_fim = end_virt_ini + TAM_PAGINA - 1;
-  int end_mem2_ini = self->processo_atual->quadro_mem2 * TAM_PAGINA + (end - end % TAM_PAGINA);
+  int end_virt_ini = pagina * self->tam_pagina;
+  int end_virt_fim = end_virt_ini + self->tam_pagina - 1;
+  int end_mem2_ini = self->processo_atual->quadro_mem2 * self->tam_pagina + (end - end % self->tam_pagina);
   int end_mem2 = end_mem2_ini;
   for (int end_virt = end_virt_ini; end_virt <= end_virt_fim; end_virt++)
   {
@@ -931,25 +1628,25 @@ static void trata_falta_de_pagina(so_t *self, int quadro_livre)
     int dado;
     if (mem_le(self->mem2, end_mem2, &dado) != ERR_OK) 
     {
-      console_printf("ERRO NO TRATAMENTO DA PAGE FAULT");
+      depura(DEP_MEM, NIVEL_ERRO, "ERRO NO TRATAMENTO DA PAGE FAULT");
       return;
     }
     end_mem2++;
     // copia o dado lido para a memória principal
-    int end_mem_principal = quadro_livre * TAM_PAGINA + (end_virt - end_virt_ini);
+    int end_mem_principal = quadro_livre * self->tam_pagina + (end_virt - end_virt_ini);
     if (mem_escreve(self->mem, end_mem_principal, dado) != ERR_OK)
     {
-      console_printf("ERRO NO TRATAMENTO DA PAGE FAULT");
+      depura(DEP_MEM, NIVEL_ERRO, "ERRO NO TRATAMENTO DA PAGE FAULT");
       return;
     }
   }
 
-  console_printf("SUBSTITUIU QUADRO %d (mem) por %d (mem2)", quadro_livre, pagina);
+  depura(DEP_MEM, NIVEL_DETALHE, "SUBSTITUIU QUADRO %d (mem) por %d (mem2)", quadro_livre, pagina);
   // altera a tabela de páginas do processo para indicar que a página está nesse quadro
   tabpag_define_quadro(self->processo_atual->tabpag, pagina, quadro_livre);
   if (tabpag_bit_acesso(self->processo_atual->tabpag, pagina))
   {
-    console_printf("TRADUÇÃO REALIZADA");
+    depura(DEP_MEM, NIVEL_DETALHE, "TRADUÇÃO REALIZADA");
   }
 }
 */
@@ -969,47 +1666,117 @@ static void so_trata_irq_err_cpu(so_t *self)
         self->processo_atual->regERRO = ERR_OK;
     }
     else if (erro == ERR_INSTR_INV) {
-        console_printf("INSTRUCAO INVALIDA pid %d", proc->pid);
+        depura(DEP_PROC, NIVEL_AVISO, "INSTRUCAO INVALIDA pid %d", proc->pid);
         self->erro_interno = true;
     }
     else {
         // Erro fatal
-        console_printf("SO: erro na CPU do processo %d: %s", proc->pid, err_nome(erro));
+        depura(DEP_PROC, NIVEL_AVISO, "SO: erro na CPU do processo %d: %s", proc->pid, err_nome(erro));
         processo_mata(self, proc->pid);
     }
 }
 
+// atualiza os medidores de ocupação da memória e dos processos, e faz uma
+//   amostra de todas as estatísticas (ver estat.h)
+static void so_amostra_estatisticas(so_t *self)
+{
+  int quadros_ocupados = 0;
+  for (int q = 0; q < self->n_quadros; q++) {
+    int pid = self->tabquadros[q].pid;
+    if (pid != SEM_PROCESSO && pid != PROTEGIDO) quadros_ocupados++;
+  }
+  int quadros_mem2_ocupados = 0;
+  for (int q = 0; q < self->n_quadros_mem2; q++) {
+    if (self->tabquadros_mem2[q].pid != SEM_PROCESSO) quadros_mem2_ocupados++;
+  }
+  int n_prontos = 0, n_bloqueados = 0;
+  for (int i = 0; i < N_MAX_PROCESSOS; i++) {
+    processo_t *p = &self->tabela_de_processos[i];
+    if (p->pid == SEM_PROCESSO) continue;
+    if (p->estado == BLOQUEADO) {
+      n_bloqueados++;
+    } else {
+      n_prontos++;
+    }
+  }
+  estat_define(self->estat_quadros_ocupados, quadros_ocupados);
+  estat_define(self->estat_quadros_mem2_ocupados, quadros_mem2_ocupados);
+  estat_define(self->estat_prontos, n_prontos);
+  estat_define(self->estat_bloqueados, n_bloqueados);
+  estat_amostra(relogio_agora());
+  self->data_proxima_amostra = relogio_agora() + self->config.intervalo_amostras;
+}
+
 // interrupção gerada quando o timer expira
 static void so_trata_irq_relogio(so_t *self)
 {
   // rearma o interruptor do relógio e reinicializa o timer para a próxima interrupção
   err_t e1, e2;
   e1 = es_escreve(self->es, D_RELOGIO_INTERRUPCAO, 0); // desliga o sinalizador de interrupção
-  e2 = es_escreve(self->es, D_RELOGIO_TIMER, INTERVALO_INTERRUPCAO);
+  e2 = es_escreve(self->es, D_RELOGIO_TIMER, self->config.intervalo_interrupcao);
   if (e1 != ERR_OK || e2 != ERR_OK) {
-    console_printf("SO: problema da reinicialização do timer");
+    depura(DEP_IRQ, NIVEL_ERRO, "SO: problema da reinicialização do timer");
     self->erro_interno = true;
   }
   // t2: deveria tratar a interrupção
   //   por exemplo, decrementa o quantum do processo corrente, quando se tem
   //   um escalonador com quantum
 
+  if (relogio_agora() >= self->data_proxima_amostra) {
+    so_amostra_estatisticas(self);
+  }
+
   // talvez seria melhor não tratar
   /*console_printf("SO: interrupção do relógio (não tratada)");*/
   self->processo_atual->quantum--;
-  if (self->processo_atual->quantum <= 0 && self->processo_atual->estado != BLOQUEADO){
-    self->processo_atual->quantum = 10;
-    processo_atualiza_prioridade(self->processo_atual);
-    fila_deque(self->processos_prontos);
-    // ATENÇÃO
+  // no fim do quantum, o processo corrente volta a ser só pronto, no fim da
+  //   fila de prontos (sem escalonador, ele continua executando)
+  if (self->processo_atual->quantum <= 0 && self->processo_atual->estado == EXECUTANDO
+      && self->config.escalonador != SEM_ESCALONADOR){
+    self->processo_atual->quantum = self->config.quantum;
+    processo_atualiza_prioridade(self, self->processo_atual);
+    processo_preempta(self->processo_atual);
+    fila_remove(self->processos_prontos, self->processo_atual->pid);
     fila_enque(self->processos_prontos, self->processo_atual->pid);
   }
 }
 
+// interrupção gerada quando chega entrada em algum terminal
+// reconhece o pedido de cada terminal e faz as leituras que estavam esperando,
+//   desbloqueando os processos atendidos
+static void so_trata_irq_teclado(so_t *self)
+{
+  for (int t = 0; t < N_TERMINAIS; t++) {
+    int terminal = D_TERM_A + t * (D_TERM_B - D_TERM_A);
+    if (es_escreve(self->es, terminal + TERM_TECLADO_OK, 0) != ERR_OK) {
+      depura(DEP_ES, NIVEL_ERRO, "SO: problema no reconhecimento da interrupção de teclado");
+      self->erro_interno = true;
+      return;
+    }
+    so_atende_espera_teclado(self, t);
+  }
+}
+
+// interrupção gerada quando a tela de algum terminal volta a aceitar caracteres
+// reconhece o pedido de cada terminal e faz as escritas que estavam esperando,
+//   desbloqueando os processos atendidos
+static void so_trata_irq_tela(so_t *self)
+{
+  for (int t = 0; t < N_TERMINAIS; t++) {
+    int terminal = D_TERM_A + t * (D_TERM_B - D_TERM_A);
+    if (es_escreve(self->es, terminal + TERM_TELA_OK, 0) != ERR_OK) {
+      depura(DEP_ES, NIVEL_ERRO, "SO: problema no reconhecimento da interrupção de tela");
+      self->erro_interno = true;
+      return;
+    }
+    so_atende_espera_tela(self, t);
+  }
+}
+
 // foi gerada uma interrupção para a qual o SO não está preparado
 static void so_trata_irq_desconhecida(so_t *self, int irq)
 {
-  console_printf("SO: não sei tratar IRQ %d (%s)", irq, irq_nome(irq));
+  depura(DEP_IRQ, NIVEL_ERRO, "SO: não sei tratar IRQ %d (%s)", irq, irq_nome(irq));
   self->erro_interno = true;
 }
 
@@ -1024,18 +1791,41 @@ static void so_chamada_escr(so_t *self);
 static void so_chamada_cria_proc(so_t *self);
 static void so_chamada_mata_proc(so_t *self);
 static void so_chamada_espera_proc(so_t *self);
+static void so_chamada_dorme(so_t *self);
+
+// conta a chamada nas estatísticas, no total e no processo
+static void so_conta_chamada(so_t *self, processo_t *proc, int id_chamada)
+{
+  int i = so_indice_chamada(id_chamada);
+  char *nome = so_nome_chamada(id_chamada);
+  if (self->estat.chamadas[i] == NULL) {
+    self->estat.chamadas[i] = estat_contador("chamadas.%s", nome);
+  }
+  if (proc->estat.chamadas[i] == NULL) {
+    proc->estat.chamadas[i] = estat_contador("proc.%d.chamadas.%s", proc->num, nome);
+  }
+  estat_soma(self->estat.chamadas[i], 1);
+  estat_soma(proc->estat.chamadas[i], 1);
+}
 
 static void so_trata_irq_chamada_sistema(so_t *self)
 {
   // a identificação da chamada está no registrador A
   // t2: com processos, o reg A deve estar no descritor do processo corrente
   int id_chamada = self->processo_atual->regA;
-  console_printf("SO: chamada de sistema %d", id_chamada);
+  depura(DEP_CHAMADA, NIVEL_DETALHE, "SO: chamada de sistema %d", id_chamada);
+  processo_t *proc = self->processo_atual;
+  so_conta_chamada(self, proc, id_chamada);
+  rastro_registra(RASTRO_CHAMADA, proc->pid, id_chamada, proc->regX);
+  proc->data_chamada = relogio_agora();
+  proc->id_chamada = id_chamada;
   switch (id_chamada) {
     case SO_LE:
+    case SO_LE_LINHA:
       so_chamada_le(self);
       break;
     case SO_ESCR:
+    case SO_ESCR_STR:
       so_chamada_escr(self);
       break;
     case SO_CRIA_PROC:
@@ -1047,88 +1837,62 @@ static void so_trata_irq_chamada_sistema(so_t *self)
     case SO_ESPERA_PROC:
       so_chamada_espera_proc(self);
       break;
+    case SO_DORME:
+      so_chamada_dorme(self);
+      break;
     default:
-      console_printf("SO: chamada de sistema desconhecida (%d)", id_chamada);
+      depura(DEP_CHAMADA, NIVEL_AVISO, "SO: chamada de sistema desconhecida (%d)", id_chamada);
       // t2: deveria matar o processo
       self->erro_interno = true;
   }
+  // se o processo bloqueou, a chamada termina quando ele for desbloqueado
+  if (proc->estado != BLOQUEADO && proc->estado != FINALIZADO) {
+    processo_termina_latencias(self, proc);
+  }
 }
 
-// implementação da chamada se sistema SO_LE
-// faz a leitura de um dado da entrada corrente do processo, coloca o dado no reg A
+// implementação das chamadas se sistema SO_LE e SO_LE_LINHA
+// faz a leitura de um dado (SO_LE, coloca o dado no reg A) ou de uma linha
+//   (SO_LE_LINHA, coloca a linha no vetor apontado por X e o número de
+//   caracteres no reg A) da entrada corrente do processo
+// a leitura é feita do buffer de entrada do terminal; se não tiver o que
+//   ler (ou se já tiver outro processo esperando), o processo é bloqueado na
+//   fila de espera do teclado, e a leitura é feita mais tarde, no
+//   atendimento da interrupção de teclado
 static void so_chamada_le(so_t *self)
 {
-  // implementação com espera ocupada
-  //   t2: deveria realizar a leitura somente se a entrada estiver disponível,
-  //     senão, deveria bloquear o processo.
-  //   no caso de bloqueio do processo, a leitura (e desbloqueio) deverá
-  //     ser feita mais tarde, em tratamentos pendentes em outra interrupção,
-  //     ou diretamente em uma interrupção específica do dispositivo, se for
-  //     o caso
-  // implementação lendo direto do terminal A
-  //   t2: deveria usar dispositivo de entrada corrente do processo
-  for (;;) {  // espera ocupada!
-    int estado;
-    if (es_le(self->es, D_TERM_A_TECLADO_OK, &estado) != ERR_OK) {
-      console_printf("SO: problema no acesso ao estado do teclado");
-      self->erro_interno = true;
-      return;
-    }
-    if (estado != 0) break;
-    // como não está saindo do SO, a unidade de controle não está executando seu laço.
-    // esta gambiarra faz pelo menos a console ser atualizada
-    // t2: com a implementação de bloqueio de processo, esta gambiarra não
-    //   deve mais existir.
-    console_tictac(self->console);
-  }
-  int dado;
-  if (es_le(self->es, D_TERM_A_TECLADO, &dado) != ERR_OK) {
-    console_printf("SO: problema no acesso ao teclado");
-    self->erro_interno = true;
+  processo_t *proc = self->processo_atual;
+  int t = processo_num_terminal(proc);
+  if (t < 0) {
+    depura(DEP_ES, NIVEL_AVISO, "SO: processo %d sem terminal para leitura", proc->pid);
+    proc->regA = -1;
     return;
   }
-  // escreve no reg A do processador
-  // (na verdade, na posição onde o processador vai pegar o A quando retornar da int)
-  // t2: se houvesse processo, deveria escrever no reg A do processo
-  // t2: o acesso só deve ser feito nesse momento se for possível; se não, o processo
-  //   é bloqueado, e o acesso só deve ser feito mais tarde (e o processo desbloqueado)
-  self->processo_atual->regA = dado;
+  Fila *espera = self->espera_teclado[t];
+  if (fila_vazia(espera) && so_le_da_entrada(self, t, proc)) return;
+  processo_bloqueia_em_dispositivo(self, proc, proc->terminal + TERM_TECLADO, espera);
 }
 
-// implementação da chamada se sistema SO_ESCR
-// escreve o valor do reg X na saída corrente do processo
+// implementação das chamadas se sistema SO_ESCR e SO_ESCR_STR
+// escreve o valor do reg X (SO_ESCR) ou a string que começa no endereço em X
+//   (SO_ESCR_STR) na saída corrente do processo
+// a escrita passa pelo buffer de saída do terminal; se o buffer encher (ou se
+//   já tiver outro processo esperando por ele), o processo é bloqueado na fila
+//   de espera da tela, e a escrita continua no atendimento da interrupção de
+//   tela
 static void so_chamada_escr(so_t *self)
 {
-  // implementação com espera ocupada
-  //   t2: deveria bloquear o processo se dispositivo ocupado
-  // implementação escrevendo direto do terminal A
-  //   t2: deveria usar o dispositivo de saída corrente do processo
-  for (;;) {
-    int estado;
-    if (es_le(self->es, D_TERM_A_TELA_OK, &estado) != ERR_OK) {
-      console_printf("SO: problema no acesso ao estado da tela");
-      self->erro_interno = true;
-      return;
-    }
-    if (estado != 0) break;
-    // como não está saindo do SO, a unidade de controle não está executando seu laço.
-    // esta gambiarra faz pelo menos a console ser atualizada
-    // t2: não deve mais existir quando houver suporte a processos, porque o SO não poderá
-    //   executar por muito tempo, permitindo a execução do laço da unidade de controle
-    console_tictac(self->console);
-  }
-  int dado;
-  // está lendo o valor de X e escrevendo o de A direto onde o processador colocou/vai pegar
-  // t2: deveria usar os registradores do processo que está realizando a E/S
-  // t2: caso o processo tenha sido bloqueado, esse acesso deve ser realizado em outra execução
-  //   do SO, quando ele verificar que esse acesso já pode ser feito.
-  dado = self->processo_atual->regX;
-  if (es_escreve(self->es, D_TERM_A_TELA, dado) != ERR_OK) {
-    console_printf("SO: problema no acesso à tela");
-    self->erro_interno = true;
+  processo_t *proc = self->processo_atual;
+  int t = processo_num_terminal(proc);
+  if (t < 0) {
+    depura(DEP_ES, NIVEL_AVISO, "SO: processo %d sem terminal para escrita", proc->pid);
+    proc->regA = -1;
     return;
   }
-  self->processo_atual->regA = 0;
+  Fila *espera = self->espera_tela[t];
+  proc->end_escrita = proc->regX;
+  if (fila_vazia(espera) && so_escreve_na_saida(self, t, proc)) return;
+  processo_bloqueia_em_dispositivo(self, proc, proc->terminal + TERM_TELA, espera);
 }
 
 // implementação da chamada se sistema SO_CRIA_PROC
@@ -1151,13 +1915,13 @@ static void so_chamada_cria_proc(so_t *self)
   if (so_copia_str_do_processo(self, 100, nome, ender_proc, *self->processo_atual)) {
     int ender_carga = -1;
     
-    console_printf("[%d] pediu para criar processo '%s' (ender_proc=%d)", self->processo_atual->pid, nome, ender_proc);
+    depura(DEP_PROC, NIVEL_INFO, "[%d] pediu para criar processo '%s' (ender_proc=%d)", self->processo_atual->pid, nome, ender_proc);
     pid = processo_cria(self, nome, &ender_carga);
-    console_printf("processo_cria retornou PID %d", pid);
+    depura(DEP_PROC, NIVEL_DETALHE, "processo_cria retornou PID %d", pid);
 
     // usado aqui para não gerar warning
     int indice_proc_criado = acha_indice_por_pid(self, pid);
-    console_printf("indice proc criado: %d\n", indice_proc_criado);
+    depura(DEP_PROC, NIVEL_DETALHE, "indice proc criado: %d\n", indice_proc_criado);
 
     if (ender_carga != -1) {
       // t2: deveria escrever no PC do descritor do processo criado
@@ -1194,20 +1958,28 @@ static void so_chamada_espera_proc(so_t *self)
   // verifica se o processo a se esperar é válido
   if (self->processo_atual->regX == self->processo_atual->pid || 
     !processo_existe(self, self->processo_atual->regX)){
-    console_printf("PROCESSO INVALIDO");
-    self->erro_interno = true;
-    // erro aqui !!!!!!
+    depura(DEP_CHAMADA, NIVEL_AVISO, "PROCESSO INVALIDO");
+    // não bloqueia, retorna erro (ver so.h)
+    self->processo_atual->regA = -1;
     return;
   }
 
-  console_printf("[%d] vai esperar o fim de [%d]", self->processo_atual->pid, self->processo_atual->regX);
+  depura(DEP_PROC, NIVEL_INFO, "[%d] vai esperar o fim de [%d]", self->processo_atual->pid, self->processo_atual->regX);
 
   // bloqueia o processo chamador
-  self->processo_atual->estado = BLOQUEADO;
-  self->processo_atual->pid_esperado = self->processo_atual->regX;
+  // processo_atualiza_prioridade(self, self->processo_atual);
+  processo_bloqueia_esperando_proc(self, self->processo_atual,
+                                   self->processo_atual->regX);
+}
 
-  // processo_atualiza_prioridade(self->processo_atual);
-  fila_deque(self->processos_prontos);
+// implementação da chamada se sistema SO_DORME
+// bloqueia o processo corrente por X instruções
+static void so_chamada_dorme(so_t *self)
+{
+  int duracao = self->processo_atual->regX;
+  self->processo_atual->regA = 0;
+  if (duracao <= 0) return;
+  processo_bloqueia_ate(self, self->processo_atual, relogio_agora() + duracao);
 }
 
 
@@ -1228,22 +2000,23 @@ static int so_carrega_programa_na_memoria_virtual(so_t *self,
 static int so_carrega_programa(so_t *self, processo_t *processo,
                                char *nome_do_executavel)
 {
-  console_printf("SO: carga de '%s'", nome_do_executavel);
+  depura(DEP_PROC, NIVEL_INFO, "SO: carga de '%s'", nome_do_executavel);
 
-  programa_t *programa = prog_cria(nome_do_executavel);
+  // o programa vem do cache de imagens, que só lê o arquivo se ele não
+  //   estiver lá ou tiver sido alterado
+  programa_t *programa = imagens_pega(self->imagens, nome_do_executavel);
   if (programa == NULL) {
-    console_printf("Erro na leitura do programa '%s'\n", nome_do_executavel);
+    depura(DEP_PROC, NIVEL_ERRO, "Erro na leitura do programa '%s'\n", nome_do_executavel);
     return -1;
   }
 
   int end_carga;
   if (processo->pid == SEM_PROCESSO) {
     end_carga = so_carrega_programa_na_memoria_fisica(self, programa);
+    imagens_devolve(self->imagens, programa);
   } else {
     end_carga = so_carrega_programa_na_memoria_virtual(self, programa, processo);
   }
-
-  prog_destroi(programa);
   return end_carga;
 }
 
@@ -1254,60 +2027,40 @@ static int so_carrega_programa_na_memoria_fisica(so_t *self, programa_t *program
 
   for (int end = end_ini; end < end_fim; end++) {
     if (mem_escreve(self->mem, end, prog_dado(programa, end)) != ERR_OK) {
-      console_printf("Erro na carga da memoria, endereco %d\n", end);
+      depura(DEP_MEM, NIVEL_ERRO, "Erro na carga da memoria, endereco %d\n", end);
       return -1;
     }
   }
 
-  console_printf("SO: carga na memoria fisica %d-%d", end_ini, end_fim);
+  depura(DEP_MEM, NIVEL_INFO, "SO: carga na memoria fisica %d-%d", end_ini, end_fim);
   return end_ini;
 }
 
-// ATENÇÃO, TEM QUE MEXER AQUI!
+// o programa não é copiado para a memória secundária: cada página é
+//   carregada da imagem na primeira vez que for acessada (ver
+//   page_fault_tratavel), e só as páginas alteradas ganham um quadro na
+//   memória secundária, quando saem da memória principal
+// o processo fica com a imagem até morrer
 static int so_carrega_programa_na_memoria_virtual(so_t *self,
                                                   programa_t *programa,
                                                   processo_t *processo)
 {
-  // 1. Calcula o espaço necessário (em bytes e páginas)
-  int prog_tamanho_bytes = prog_tamanho(programa);
-  int end_virt_ini = 0;
-  int end_virt_fim = end_virt_ini + prog_tamanho_bytes - 1;
-  
-  int pagina_ini = end_virt_ini / TAM_PAGINA;
-  int pagina_fim = end_virt_fim / TAM_PAGINA;
-  int n_paginas = pagina_fim - pagina_ini + 1;
-
-  // 2. Aloca espaço na memória secundária (DISCO/mem2)
-  // Ela usa 'bloco_livre' como um ponteiro linear na mem_fisica.
-  // Você usa 'quadro_livre_mem2' para contar QUADROS. Vamos adaptar para endereços lineares como ela.
-  // Se 'quadro_livre_mem2' for um endereço, OK. Se for índice de quadro, precisa multiplicar.
-  // Assumindo que você quer seguir a lógica dela (endereço linear):
-  
-  // usa o próximo endereço livre no disco
-  int end_fis_ini = self->quadro_livre_mem2; 
-  int end_fis = end_fis_ini;
-
-  // copia o programa para o disco (mem2)
-  for (int end_virt = end_virt_ini; end_virt <= end_virt_fim; end_virt++) {
-      if (mem_escreve(self->mem2, end_fis, prog_dado(programa, end_virt)) != ERR_OK) {
-            console_printf("Erro na carga da memória secundaria, end virt %d fís %d\n", end_virt, end_fis);
-            return -1;
-      }
-      end_fis++;
+  int tamanho = prog_tamanho(programa);
+  int n_paginas = (tamanho + self->tam_pagina - 1) / self->tam_pagina;
+
+  processo->imagem = programa;
+  processo->tam_mem_virt = tamanho;
+  processo->quadro_mem2 = malloc(n_paginas * sizeof(int));
+  assert(processo->quadro_mem2 != NULL || n_paginas == 0);
+  for (int pagina = 0; pagina < n_paginas; pagina++) {
+    processo->quadro_mem2[pagina] = SEM_QUADRO;
   }
 
-  // atualiza o ponteiro de espaço livre no disco
-  // o próximo programa começará onde este terminou
-  self->quadro_livre_mem2 = end_fis; 
-
-  // salva o endereço inicial no disco no processo
-  processo->quadro_mem2 = end_fis_ini;
+  depura(DEP_MEM, NIVEL_INFO, "SO: carga do processo %d sob demanda, V0-%d npag=%d",
+         processo->pid, tamanho - 1, n_paginas);
 
-  console_printf("SO: carga na memoria secundaria V%d-%d F%d-%d npag=%d",
-                  end_virt_ini, end_virt_fim, end_fis_ini, end_fis - 1, n_paginas);
-                  
-  // retornando 0 (end_virt_ini) para o regPC iniciar certo.
-  return end_virt_ini; 
+  // os programas são montados para executar a partir do endereço 0
+  return 0;
 }
 
 
@@ -1325,21 +2078,11 @@ static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
                                      int end_virt, processo_t processo)
 {
   if (processo.pid == SEM_PROCESSO) return false;
-  
-  // ATENÇÃO DÚVIDA SE PRECISA DISSO MESMO
-  mmu_define_tabpag(self->mmu, processo.tabpag);
 
   for (int indice_str = 0; indice_str < tam; indice_str++) {
     int caractere;
-    // não tem memória virtual implementada, posso usar a mmu para traduzir
-    //   os endereços e acessar a memória, porque todo o conteúdo do processo
-    //   está na memória principal, e só temos uma tabela de páginas
-    if (mmu_le(self->mmu, end_virt + indice_str, &caractere, usuario) != ERR_OK) {
+    if (so_le_mem_processo(self, &processo, end_virt + indice_str, &caractere) != ERR_OK) {
       return false;
-
-      //return false;
-      // se não está na memória principal, busca na memória secundária (disco)
-      mem_le(self->mem2, processo.quadro_mem2 + end_virt + indice_str, &caractere);
     }
     if (caractere < 0 || caractere > 255) {
       return false;
@@ -1353,4 +2096,115 @@ static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
   return false;
 }
 
+// coloca em '*pvalor' o valor que está no endereço virtual 'end_virt' do
+//   processo 'proc'
+// a leitura é feita sem passar pela MMU (que está com a tabela do processo
+//   corrente) e sem causar falta de página: se a página está num quadro da
+//   memória principal lê de lá, senão lê da memória secundária ou da imagem
+//   do programa
+static err_t so_le_mem_processo(so_t *self, processo_t *proc, int end_virt,
+                                int *pvalor)
+{
+  if (end_virt < 0 || end_virt >= proc->tam_mem_virt) return ERR_END_INV;
+  int quadro;
+  if (tabpag_traduz(proc->tabpag, end_virt / self->tam_pagina, &quadro) == ERR_OK) {
+    return mem_le(self->mem, quadro * self->tam_pagina + end_virt % self->tam_pagina, pvalor);
+  }
+  return so_le_fora_da_mem(self, proc, end_virt, pvalor);
+}
+
+// coloca 'valor' no endereço virtual 'end_virt' do processo 'proc'
+// como so_le_mem_processo, não passa pela MMU nem causa falta de página; se
+//   a página está num quadro, escreve nele e marca a página como alterada,
+//   senão escreve na memória secundária, de onde a página vai ser carregada
+//   quando for usada (se a página ainda não tem quadro na memória
+//   secundária, ganha um, com o conteúdo da imagem)
+static err_t so_escreve_mem_processo(so_t *self, processo_t *proc, int end_virt,
+                                     int valor)
+{
+  if (end_virt < 0 || end_virt >= proc->tam_mem_virt) return ERR_END_INV;
+  int pagina = end_virt / self->tam_pagina;
+  int quadro;
+  if (tabpag_traduz(proc->tabpag, pagina, &quadro) == ERR_OK) {
+    tabpag_marca_bit_acesso(proc->tabpag, pagina, true);
+    return mem_escreve(self->mem, quadro * self->tam_pagina + end_virt % self->tam_pagina, valor);
+  }
+  if (proc->quadro_mem2[pagina] == SEM_QUADRO) {
+    int ini = pagina * self->tam_pagina;
+    int dados[self->tam_pagina];
+    for (int offset = 0; offset < self->tam_pagina; offset++) {
+      so_le_fora_da_mem(self, proc, ini + offset, &dados[offset]);
+    }
+    quadro = so_aloca_quadro_mem2(self, proc, pagina);
+    if (quadro < 0) return ERR_END_INV;
+    for (int offset = 0; offset < self->tam_pagina; offset++) {
+      err_t err = mem_escreve(self->mem2, quadro * self->tam_pagina + offset, dados[offset]);
+      if (err != ERR_OK) return err;
+    }
+  }
+  quadro = proc->quadro_mem2[pagina];
+  return mem_escreve(self->mem2, quadro * self->tam_pagina + end_virt % self->tam_pagina, valor);
+}
+
+
+// ---------------------------------------------------------------------
+// PERFIL {{{1
+// ---------------------------------------------------------------------
+
+// profundidade máxima da pilha reconstruída
+#define MAX_QUADROS_PERFIL 32
+
+// a CPU chama esta função a cada config.perfil instruções, com o PC da
+//   próxima instrução a executar
+// em modo usuário, a amostra é a pilha de chamadas do processo corrente:
+//   o PC está na subrotina mais interna que o contém (ver simbolos.h), e
+//   quem a chamou está logo antes do endereço de retorno, que CHAMA deixou
+//   no endereço da subrotina; a reconstrução para fora de qualquer
+//   subrotina, ou na profundidade máxima (como as subrotinas não são
+//   reentrantes, um endereço de retorno pode ser de uma chamada antiga)
+// as amostras em modo supervisor contam como [so], e com a CPU parada
+//   como [ocioso]
+static void so_amostra_perfil(void *arg, int PC, cpu_modo_t modo, bool parada)
+{
+  so_t *self = arg;
+  processo_t *proc = self->processo_atual;
+  if (parada) {
+    perfil_conta(self->perfil, "[ocioso]");
+    return;
+  }
+  if (modo == supervisor || !self->cpu_com_processo || proc->pid == SEM_PROCESSO) {
+    perfil_conta(self->perfil, "[so]");
+    return;
+  }
+
+  // nomes das subrotinas, da mais interna para a mais externa
+  simbolos_t *simbolos = perfil_simbolos(self->perfil, proc->executavel);
+  char enderecos[MAX_QUADROS_PERFIL][12];
+  char *quadros[MAX_QUADROS_PERFIL];
+  int n = 0;
+  int pc = PC;
+  while (n < MAX_QUADROS_PERFIL) {
+    int rotina = (simbolos == NULL) ? -1 : simbolos_rotina(simbolos, pc);
+    char *nome = (simbolos == NULL) ? NULL : simbolos_nome(simbolos, (rotina < 0) ? pc : rotina);
+    if (nome == NULL) {
+      snprintf(enderecos[n], sizeof(enderecos[n]), "@%d", pc);
+      nome = enderecos[n];
+    }
+    quadros[n++] = nome;
+    int retorno;
+    if (rotina < 0 || so_le_mem_processo(self, proc, rotina, &retorno) != ERR_OK
+        || retorno < 2) {
+      break;
+    }
+    pc = retorno - 2;
+  }
+
+  char pilha[MAX_QUADROS_PERFIL * 40];
+  int tam = snprintf(pilha, sizeof(pilha), "%s[%d]", proc->executavel, proc->pid);
+  for (int i = n - 1; i >= 0 && tam < (int)sizeof(pilha); i--) {
+    tam += snprintf(pilha + tam, sizeof(pilha) - tam, ";%s", quadros[i]);
+  }
+  perfil_conta(self->perfil, pilha);
+}
+
 // vim: foldmethod=marker
@@ -13,6 +13,7 @@ typedef struct so_t so_t;
 #include "cpu.h"
 #include "es.h"
 #include "console.h" // só para uma gambiarra
+#include "config.h"
 
 // funções de processos
 
@@ -31,8 +32,9 @@ bool todos_processos_encerrados(so_t *self);
 // acha o índice de um processo na tablea aparti do pid
 int acha_indice_por_pid(so_t *self, int pid);
 
+// cria o SO, com os parâmetros em 'config' (que é copiada)
 so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_secundaria, mmu_t *mmu,
-              es_t *es, console_t *console);
+              es_t *es, console_t *console, config_t *config);
 void so_destroi(so_t *self);
 
 // Chamadas de sistema
@@ -53,11 +55,31 @@ void so_destroi(so_t *self);
 // retorna em A: o caractere lido ou um código de erro negativo
 #define SO_LE          1
 
+// lê uma linha do dispositivo de entrada do processo
+// recebe em X o endereço de um vetor na memória do processo; a primeira
+//   posição do vetor contém o número máximo de caracteres a ler, os
+//   caracteres lidos são colocados a partir da posição seguinte, seguidos
+//   de um valor 0
+// o fim de linha ('\n') não é colocado no vetor; se a linha for maior que
+//   o vetor, o restante fica para a próxima leitura
+// retorna em A: o número de caracteres lidos ou um código de erro negativo
+// o processo bloqueia até que uma linha completa tenha sido digitada
+#define SO_LE_LINHA   12
+
 // escreve um caractere no dispositivo de saída do processo
 // recebe em X o caractere a escrever
 // retorna em A: 0 se OK ou um código de erro negativo
 #define SO_ESCR        2
 
+// escreve uma string no dispositivo de saída do processo
+// os caracteres da string estão na memória do processo que realiza esta
+//   chamada, a partir da posição em X até antes da posição que contém um
+//   valor 0
+// retorna em A: 0 se OK ou um código de erro negativo; X não é alterado
+// a string é copiada para um buffer do SO; o processo só bloqueia se esse
+//   buffer encher antes do fim da string
+#define SO_ESCR_STR   11
+
 // #define SO_ABRE        3
 // #define SO_FECHA       4
 // #define SO_SEL_LE      5
@@ -94,4 +116,11 @@ void so_destroi(so_t *self);
 // retorna sem bloquear, com erro, se não existir processo com esse pid
 #define SO_ESPERA_PROC 9
 
+// suspende a execução do processo chamador por um tempo
+// recebe em X o número de instruções a dormir
+// retorna em A: 0
+// o processo fica bloqueado até que o relógio chegue a agora+X; se X não
+//   for positivo, retorna sem bloquear
+#define SO_DORME      10
+
 #endif // SO_H
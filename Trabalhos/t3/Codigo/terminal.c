@@ -6,24 +6,32 @@
 #include "terminal.h"
 
 #include <stdlib.h>
-#include <string.h>
 #include <assert.h>
 
 // TERMINAL
 
+// buffer circular de caracteres
+typedef struct {
+  char *buf;
+  int cap;  // número de posições em buf
+  int ini;  // posição do primeiro caractere
+  int n;    // número de caracteres no buffer
+} anel_t;
+
 // dados para um terminal
 struct terminal_t {
   // número de caracteres que cabem em uma linha
   int tam_linha;
   // texto já digitado no terminal, esperando para ser lido
-  char *entrada;
+  anel_t entrada;
   // texto sendo mostrado na saída do terminal
-  char *saida;
+  anel_t saida;
   // estado da saída do terminal, que pode ser:
   // normal: aceitando novos caracteres na saída
   // rolando: removendo um caractere no início para gerar espaço.
-  //   move um caractere por vez para a esquerda, até chegar no final
-  //   da linha, então volta ao estado normal.
+  //   o caractere é removido do buffer quando a rolagem inicia, e um espaço
+  //   é mostrado em pos_rolagem, que anda um caractere para a direita por
+  //   vez, até chegar no final da linha, então volta ao estado normal.
   //   entra neste estado quando recebe um caractere na última posição.
   //   não aceita novos caracteres
   // limpando: removendo um caractere no início da linha por vez, até
@@ -31,11 +39,51 @@ struct terminal_t {
   //   entra nesse estado quando recebe um '\n'.
   //   não aceita novos caracteres
   enum { normal, rolando, limpando } estado_saida;
-  // posicao do caractere que está sendo movido durante uma rolagem
+  // posicao do espaço que está sendo movido durante uma rolagem
   int pos_rolagem;
+  // se true, a rolagem e a limpeza são feitas de uma vez, sem passar pelos
+  //   estados rolando e limpando
+  bool rapido;
+  // pedidos de interrupção ainda não reconhecidos
+  bool int_teclado;
+  bool int_tela;
+  // cópias em string da entrada e da saída, só para o desenho na console;
+  //   são refeitas quando pedidas, se o conteúdo tiver sido alterado
+  char *txt_entrada;
+  char *txt_saida;
+  bool txt_entrada_ok;
+  bool txt_saida_ok;
 };
 
 
+static void anel_cria(anel_t *self, int cap)
+{
+  self->buf = malloc(cap);
+  assert(self->buf != NULL);
+  self->cap = cap;
+  self->ini = 0;
+  self->n = 0;
+}
+
+static void anel_insere(anel_t *self, char ch)
+{
+  self->buf[(self->ini + self->n) % self->cap] = ch;
+  self->n++;
+}
+
+static char anel_remove(anel_t *self)
+{
+  char ch = self->buf[self->ini];
+  self->ini = (self->ini + 1) % self->cap;
+  self->n--;
+  return ch;
+}
+
+static char anel_char(anel_t *self, int pos)
+{
+  return self->buf[(self->ini + pos) % self->cap];
+}
+
 terminal_t *terminal_cria(int tam_linha)
 {
   terminal_t *self = malloc(sizeof(*self));
@@ -43,44 +91,52 @@ terminal_t *terminal_cria(int tam_linha)
 
   self->tam_linha = tam_linha;
 
-  self->saida = calloc(1, tam_linha + 1);
-  self->entrada = calloc(1, tam_linha + 1);
-  assert(self->saida != NULL && self->entrada != NULL);
+  // a entrada aceita até tam_linha-2 caracteres, a saída até tam_linha-1
+  anel_cria(&self->entrada, tam_linha);
+  anel_cria(&self->saida, tam_linha);
+  self->txt_entrada = calloc(1, tam_linha + 1);
+  self->txt_saida = calloc(1, tam_linha + 1);
+  assert(self->txt_saida != NULL && self->txt_entrada != NULL);
+  self->txt_entrada_ok = true;
+  self->txt_saida_ok = true;
 
   self->estado_saida = normal;
+  self->rapido = false;
+  self->int_teclado = false;
+  self->int_tela = false;
 
   return self;
 }
 
 void terminal_destroi(terminal_t *self)
 {
-  free(self->entrada);
-  free(self->saida);
+  free(self->entrada.buf);
+  free(self->saida.buf);
+  free(self->txt_entrada);
+  free(self->txt_saida);
   free(self);
 }
 
 static bool terminal_entrada_vazia(terminal_t *self)
 {
-  return self->entrada[0] == '\0';
+  return self->entrada.n == 0;
 }
 
 static err_t terminal_le_char(terminal_t *self, int *pch)
 {
   if (terminal_entrada_vazia(self)) return ERR_OCUP;
-  char *p = self->entrada;
-  *pch = *p;
-  memmove(p, p + 1, strlen(p));
+  *pch = anel_remove(&self->entrada);
+  self->txt_entrada_ok = false;
   return ERR_OK;
 }
 
 void terminal_insere_char(terminal_t *self, char ch)
 {
-  char *p = self->entrada;
-  int tam = strlen(p);
   // se não cabe, ignora silenciosamente
-  if (tam >= self->tam_linha - 2) return;
-  p[tam] = ch;
-  p[tam + 1] = '\0';
+  if (self->entrada.n >= self->tam_linha - 2) return;
+  anel_insere(&self->entrada, ch);
+  self->txt_entrada_ok = false;
+  self->int_teclado = true;
 }
 
 static bool terminal_pode_imprimir(terminal_t *self)
@@ -92,19 +148,24 @@ static err_t terminal_imprime(terminal_t *self, char ch)
 {
   if (!terminal_pode_imprimir(self)) return ERR_OCUP;
 
+  self->txt_saida_ok = false;
   if (ch == '\n') {
     // se for impresso \n, inicia a limpeza da linha
-    self->estado_saida = limpando;
+    if (self->rapido) {
+      self->saida.n = 0;
+    } else if (self->saida.n > 0) {
+      self->estado_saida = limpando;
+    }
   } else {
     // insere o caractere no final da linha
-    int tam = strlen(self->saida);
-    self->saida[tam] = ch;
-    tam++;
-    self->saida[tam] = '\0';
+    anel_insere(&self->saida, ch);
     // se encheu a linha, inicia a rolagem
-    if (tam >= self->tam_linha - 1) {
-      self->estado_saida = rolando;
-      self->pos_rolagem = 0;
+    if (self->saida.n >= self->tam_linha - 1) {
+      anel_remove(&self->saida);
+      if (!self->rapido) {
+        self->estado_saida = rolando;
+        self->pos_rolagem = 0;
+      }
     }
   }
   return ERR_OK;
@@ -112,50 +173,93 @@ static err_t terminal_imprime(terminal_t *self, char ch)
 
 void terminal_limpa_saida(terminal_t *self)
 {
-  self->saida[0] = '\0';
+  self->saida.n = 0;
+  self->txt_saida_ok = false;
+  if (self->estado_saida != normal) self->int_tela = true;
   self->estado_saida = normal;
 }
 
+void terminal_define_rapido(terminal_t *self, bool rapido)
+{
+  self->rapido = rapido;
+  // termina de uma vez o que estiver em andamento
+  if (rapido && self->estado_saida != normal) {
+    if (self->estado_saida == limpando) self->saida.n = 0;
+    self->estado_saida = normal;
+    self->txt_saida_ok = false;
+    self->int_tela = true;
+  }
+}
+
 static void terminal_atualiza_rolagem(terminal_t *self)
 {
   if (self->estado_saida != rolando) return;
-  // rola um caractere e avança a posição de rolagem
-  char *p = self->saida;
-  char ch = p[self->pos_rolagem + 1];
-  p[self->pos_rolagem] = ch;
+  // avança a posição do espaço da rolagem
   self->pos_rolagem++;
-  p[self->pos_rolagem] = ' ';
-  // se chegou no final da string, volta ao estado normal
-  if (ch == '\0') self->estado_saida = normal;
+  self->txt_saida_ok = false;
+  // se passou do final da linha, volta ao estado normal
+  if (self->pos_rolagem > self->saida.n) {
+    self->estado_saida = normal;
+    self->int_tela = true;
+  }
 }
 
 static void terminal_atualiza_limpeza(terminal_t *self)
 {
   if (self->estado_saida != limpando) return;
-  // remove um caractere do início da string
-  char *p = self->saida;
-  int tam = strlen(p);
-  memmove(p, p + 1, tam);
-  tam--;
+  // remove um caractere do início da linha
+  anel_remove(&self->saida);
+  self->txt_saida_ok = false;
   // volta ao estado normal se era o último
-  if (tam <= 0) self->estado_saida = normal;
+  if (self->saida.n <= 0) {
+    self->estado_saida = normal;
+    self->int_tela = true;
+  }
 }
 
-// altera a string de saída em 1 caractere, se estiver rolando ou limpando
+// altera a linha de saída em 1 caractere, se estiver rolando ou limpando
 void terminal_tictac(terminal_t *self)
 {
   terminal_atualiza_rolagem(self);
   terminal_atualiza_limpeza(self);
 }
 
+bool terminal_tem_interrupcao(terminal_t *self, int id)
+{
+  if (id == TERM_TECLADO) return self->int_teclado;
+  if (id == TERM_TELA) return self->int_tela;
+  return false;
+}
+
 char *terminal_txt_entrada(terminal_t *self)
 {
-  return self->entrada;
+  if (!self->txt_entrada_ok) {
+    int n = self->entrada.n;
+    for (int i = 0; i < n; i++) {
+      self->txt_entrada[i] = anel_char(&self->entrada, i);
+    }
+    self->txt_entrada[n] = '\0';
+    self->txt_entrada_ok = true;
+  }
+  return self->txt_entrada;
 }
 
 char *terminal_txt_saida(terminal_t *self)
 {
-  return self->saida;
+  if (!self->txt_saida_ok) {
+    // durante a rolagem, aparece um espaço em pos_rolagem
+    char *p = self->txt_saida;
+    for (int i = 0; i < self->saida.n; i++) {
+      if (self->estado_saida == rolando && i == self->pos_rolagem) *p++ = ' ';
+      *p++ = anel_char(&self->saida, i);
+    }
+    if (self->estado_saida == rolando && self->pos_rolagem == self->saida.n) {
+      *p++ = ' ';
+    }
+    *p = '\0';
+    self->txt_saida_ok = true;
+  }
+  return self->txt_saida;
 }
 
 // Operações de leitura e escrita no terminal, chamadas pelo controlador de E/S
@@ -186,7 +290,17 @@ err_t terminal_escrita(void *disp, int id, int valor)
 {
   terminal_t *self = disp;
   int subdisp = id % 4;
-  // só pode escrever na tela
-  if (subdisp != TERM_TELA) return ERR_OP_INV;
-  return terminal_imprime(self, valor);
+  switch (subdisp) {
+    case TERM_TELA: // escrita na tela
+      return terminal_imprime(self, valor);
+    case TERM_TECLADO_OK: // reconhecimento da interrupção de teclado
+      self->int_teclado = false;
+      break;
+    case TERM_TELA_OK: // reconhecimento da interrupção de tela
+      self->int_tela = false;
+      break;
+    default:
+      return ERR_OP_INV;
+  }
+  return ERR_OK;
 }
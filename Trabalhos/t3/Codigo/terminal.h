@@ -25,6 +25,18 @@
 //   gerar espaço para o novo. a impressão de um \n causa a "limpeza" da linha.
 // a escrita não é possível se a saída estiver rolando ou sendo limpa, o que é
 //   feito um caractere por vez (a cada chamada a tictac).
+// no modo rápido, a rolagem e a limpeza são feitas de uma vez, e a saída está
+//   sempre pronta para receber caracteres.
+//
+// a entrada e a saída são mantidas em buffers circulares; as strings
+//   retornadas por terminal_txt_entrada e terminal_txt_saida são cópias para
+//   o desenho, e são válidas até a próxima operação no terminal.
+//
+// o terminal pede interrupção de teclado quando recebe um caractere na entrada,
+//   e interrupção de tela quando a saída volta a aceitar caracteres depois de
+//   uma rolagem ou limpeza. o pedido fica ativo até ser reconhecido, com uma
+//   escrita no dispositivo de estado correspondente (TERM_TECLADO_OK ou
+//   TERM_TELA_OK).
 //
 // além das funções que implementam as operações de E/S acessadas pelo controlador
 //   de E/S, contém as funções para o controle do terminal, realizado pela console.
@@ -62,9 +74,17 @@ void terminal_insere_char(terminal_t *self, char ch);
 // limpa a linha de saída (para uso pela console)
 void terminal_limpa_saida(terminal_t *self);
 
+// liga ou desliga o modo rápido, em que a rolagem e a limpeza da saída são
+//   feitas de uma vez (para uso pela console)
+void terminal_define_rapido(terminal_t *self, bool rapido);
+
 // esta função deve ser chamada periodicamente
 void terminal_tictac(terminal_t *self);
 
+// retorna true se o terminal está pedindo interrupção
+// 'id' é TERM_TECLADO (tem entrada nova) ou TERM_TELA (saída livre)
+bool terminal_tem_interrupcao(terminal_t *self, int id);
+
 // Funções para implementar o protocolo de acesso a um dispositivo pelo
 //   controlador de E/S
 // Devem seguir o protocolo f_leitura_t e f_escrita_t declarados em es.h